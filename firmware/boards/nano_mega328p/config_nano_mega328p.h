@@ -38,6 +38,23 @@
 #define XTH_XCVR_RESET_DDR  DDRC
 #define XTH_XCVR_RESET_BIT  2
 
+#ifdef USE_XT_SECOND_KBD
+    #define XTH_XCVR_INSTANCES 2
+
+    // Second XT Clock on PD3 (INT1)
+    #define XTH_XCVR_CLOCK2_INTERRUPT 1
+    #define XTH_XCVR_CLOCK2_PORT PORTD
+    #define XTH_XCVR_CLOCK2_PINS PIND
+    #define XTH_XCVR_CLOCK2_DDR  DDRD
+    #define XTH_XCVR_CLOCK2_BIT  3
+
+    // Second XT Data on PD4
+    #define XTH_XCVR_DATA2_PORT PORTD
+    #define XTH_XCVR_DATA2_PINS PIND
+    #define XTH_XCVR_DATA2_DDR  DDRD
+    #define XTH_XCVR_DATA2_BIT  4
+#endif
+
 // PS2 Clock on PC3 
 #define PS2D_XCVR_CLOCK_PORT PORTC
 #define PS2D_XCVR_CLOCK_PINS PINC
@@ -54,6 +71,12 @@
 #define PS2D_XCVR_CLOCK_INTERRUPT_VECTOR TIMER0_COMPA_vect
 #define PS2D_XCVR_DATA_INTERRUPT_VECTOR TIMER0_COMPB_vect
 
+// PS2 Clock/Data pin change (PCINT11/PCINT12) wakes the idle bus timer
+#define PS2D_XCVR_WAKE_INTERRUPT_VECTOR PCINT1_vect
+#define PS2D_XCVR_WAKE_PCMSK PCMSK1
+#define PS2D_XCVR_WAKE_PCIE  PCIE1
+#define PS2D_XCVR_WAKE_MASK  ((1 << PCINT11) | (1 << PCINT12))
+
 #define PS2D_KBD_POR_DURATION 150UL
 #define PS2D_KBD_BAT_DURATION 300UL
 
@@ -1,5 +1,6 @@
 USE_CONSOLE = yes
 USE_TYPEMATIC = yes
+USE_XT_SECOND_KBD = no
 
 # Target device
 MCU ?= atmega328p
@@ -34,6 +34,23 @@
 #define XTH_XCVR_RESET_DDR  DDRB
 #define XTH_XCVR_RESET_BIT  5
 
+#ifdef USE_XT_SECOND_KBD
+    #define XTH_XCVR_INSTANCES 2
+
+    // Second XT Clock on PE6 (INT6), INT2/INT3 are the console USART
+    #define XTH_XCVR_CLOCK2_INTERRUPT 6
+    #define XTH_XCVR_CLOCK2_PORT PORTE
+    #define XTH_XCVR_CLOCK2_PINS PINE
+    #define XTH_XCVR_CLOCK2_DDR  DDRE
+    #define XTH_XCVR_CLOCK2_BIT  6
+
+    // Second XT Data on PB4
+    #define XTH_XCVR_DATA2_PORT PORTB
+    #define XTH_XCVR_DATA2_PINS PINB
+    #define XTH_XCVR_DATA2_DDR  DDRB
+    #define XTH_XCVR_DATA2_BIT  4
+#endif
+
 // PS2 Clock on PC6
 #define PS2D_XCVR_CLOCK_PORT PORTC
 #define PS2D_XCVR_CLOCK_PINS PINC
@@ -50,6 +67,8 @@
 #define PS2D_XCVR_CLOCK_INTERRUPT_VECTOR TIMER0_COMPA_vect
 #define PS2D_XCVR_DATA_INTERRUPT_VECTOR TIMER0_COMPB_vect
 
+// PC6/PD7 have no pin change interrupt, the idle bus timer polls the bus
+
 #define PS2D_KBD_POR_DURATION 150UL
 #define PS2D_KBD_BAT_DURATION 300UL
 
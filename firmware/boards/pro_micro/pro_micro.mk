@@ -1,5 +1,6 @@
 USE_CONSOLE = no
 USE_TYPEMATIC = yes
+USE_XT_SECOND_KBD = no
 
 # Target device
 MCU ?= atmega32u4
@@ -39,15 +39,56 @@
 #define XTH_XCVR_RESET_DDR  DDRD
 #define XTH_XCVR_RESET_BIT  6
 
+/* Number of XT keyboards, 1 or 2. The reset line belongs to the first */
+#define XTH_XCVR_INSTANCES 1
+
+/* Second XT Clock on PD2 (INT2), only used when XTH_XCVR_INSTANCES is 2 */
+#define XTH_XCVR_CLOCK2_INTERRUPT 2
+#define XTH_XCVR_CLOCK2_PORT PORTD
+#define XTH_XCVR_CLOCK2_PINS PIND
+#define XTH_XCVR_CLOCK2_DDR  DDRD
+#define XTH_XCVR_CLOCK2_BIT  2
+
+/* Second XT Data on PD3 */
+#define XTH_XCVR_DATA2_PORT PORTD
+#define XTH_XCVR_DATA2_PINS PIND
+#define XTH_XCVR_DATA2_DDR  DDRD
+#define XTH_XCVR_DATA2_BIT  3
+
 /* Receive buffer size */
 #define XTH_RECV_BUFFER_SIZE 16
 
+/* Key chatter filter window, 0 disables */
+#define XTH_KBD_DEBOUNCE_MS 5U /* milliseconds */
+
+/* Keys debounced at once */
+#define XTH_KBD_DEBOUNCE_SLOTS 4
+
+/* Scan codes queued before the clock is held low */
+#define XTH_XCVR_RECV_QUEUE_SIZE 8 /* Power of 2, 1 holds after every scan code */
+
+/* Clock edges captured by the clock ISR awaiting decoding, 9-10 per frame.
+ * The clock is held after a frame once another would not fit. */
+#define XTH_XCVR_EDGE_QUEUE_SIZE 32 /* Power of 2, 16 - 128, over 10 per keyboard */
+
 /* Start of frame threshold */
 #define XTH_XCVR_SOF_THRESHOLD 200U /* Microseconds */
 
+/* Clock edges closer than this to the previous edge are ignored */
+#define XTH_XCVR_GLITCH_THRESHOLD 10U /* Microseconds, 0 disables */
+
+/* Record receive statistics (bit period, resyncs, overflows) */
+#define XTH_XCVR_STATS_ENABLE 1
+
 /* Use 1 start bit */
 #define XTH_XCVR_1_START_BIT 0
 
+/* Detect start bits and clock period from the first frame received */
+#define XTH_XCVR_PROTOCOL_DETECT 1
+
+/* Consecutive framing errors that discard the detected protocol */
+#define XTH_XCVR_PROTOCOL_RELOCK_ERRORS 4
+
 /* Enable use of Reset line */
 #define XTH_XCVR_RESET_LINE_ENABLE 0
 
@@ -88,12 +129,33 @@
 /* PS/2 Data timer interrupt */
 #define PS2D_XCVR_DATA_INTERRUPT_VECTOR TIMER0_COMPB_vect
 
+/* Report the worst case PS/2 bus timer ISR delay to the console */
+#define PS2D_XCVR_TICK_DELAY_STATS 1
+
+/* Bus idle time before the bus timer is slowed, 0 disables idle mode */
+#define PS2D_XCVR_IDLE_MODE_DELAY 50U /* milliseconds */
+
+/* Optional pin change interrupt covering the PS/2 Clock and Data lines
+ * that wakes the idle bus timer. Without it the slowed timer polls the
+ * bus. PF4/PF5 have no pin change interrupt, e.g. for PB4/PB5:
+ * #define PS2D_XCVR_WAKE_INTERRUPT_VECTOR PCINT0_vect
+ * #define PS2D_XCVR_WAKE_PCMSK PCMSK0
+ * #define PS2D_XCVR_WAKE_PCIE  PCIE0
+ * #define PS2D_XCVR_WAKE_MASK  ((1 << PCINT4) | (1 << PCINT5)) */
+
 /* PS/2 Power-On-Reset duration */
 #define PS2D_KBD_POR_DURATION 150UL
 
 /* PS/2 Basic-Assurance-Test duration */
 #define PS2D_KBD_BAT_DURATION 300UL
 
+/* PS/2 fast boot. Allows POR/BAT durations below the IBM minimums and
+ * ends the power-on POR/BAT early when a running host is detected */
+#define PS2D_KBD_FAST_BOOT 0
+
+/* Bus idle time indicating a running host when fast boot is enabled */
+#define PS2D_KBD_FAST_BOOT_HOST_IDLE 10UL /* milliseconds */
+
 /* PS/2 receive queue size */
 #define PS2D_RECV_STORAGE_SIZE 16
 
@@ -106,6 +168,10 @@
 /* Key event queue size */
 #define KEYEVENT_QUEUE_SIZE 10
 
+/* Keys held at once that are released with the KeyCode they were pressed
+ * with, across keymap and layer changes */
+#define KEYMAP_HELD_KEYS 10
+
 /* Bus power detect pin */
 #define BOARD_POWER_DETECT_PORT PORTC
 #define BOARD_POWER_DETECT_PINS PINC
@@ -117,6 +183,19 @@
     #define CONSOLE_BAUD_PRESCALE (((F_CPU / (CONSOLE_BAUD_RATE * 16UL))) - 1)
     #define CONSOLE_SEND_BUFFER_SIZE 128
 
+    /* Compile time severity filtering, call sites outside the mask are
+     * removed. Set the default for all sources and optionally override 
+     * per source, e.g. errors only except key mapping events:
+     *   #define CONSOLE_SEVERITY_MASK CON_SEV_ERROR
+     *   #define CONSOLE_SEVERITY_MASK_KEYMAP (CON_SEV_ERROR | CON_SEV_TRACE_EVENT)
+     * Sources: CONSOLE, XTH_XCVR, XTH_KBD, PS2D_XCVR, PS2D_KBD, XT2PS2,
+     * KEYMAP, TEST */
+
+    /* MCUs without a USART (ATtiny85) use a transmit only software UART
+     * clocked by the PS/2 transceiver timer. CONSOLE_BAUD_RATE must then
+     * match the PS/2 transceiver interrupt rate and the transmit pin is
+     * selected with CONSOLE_TX_PORT, CONSOLE_TX_DDR and CONSOLE_TX_BIT */
+
 #endif
 
 /* Task scheduler update interval */
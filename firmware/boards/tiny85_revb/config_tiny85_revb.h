@@ -47,6 +47,12 @@
 #define PS2D_XCVR_DATA_INTERRUPT_VECTOR TIMER0_COMPB_vect
 #define PS2D_XCVR_IDLE_INTERRUPT_VECTOR TIMER0_OVF_vect
 
+// PS2 Clock/Data pin change (PCINT3/PCINT4) wakes the idle bus timer
+#define PS2D_XCVR_WAKE_INTERRUPT_VECTOR PCINT0_vect
+#define PS2D_XCVR_WAKE_PCMSK PCMSK
+#define PS2D_XCVR_WAKE_PCIE  PCIE
+#define PS2D_XCVR_WAKE_MASK  ((1 << PCINT3) | (1 << PCINT4))
+
 // XT Reset on PB1
 #define XTH_XCVR_RESET_PORT PORTB
 #define XTH_XCVR_RESET_PINS PINB
@@ -54,10 +60,30 @@
 #define XTH_XCVR_RESET_BIT  1
 
 #define XTH_RECV_BUFFER_SIZE 16
+#define XTH_XCVR_EDGE_QUEUE_SIZE 16
+
+// Single XT keyboard only, INT0 is the only external interrupt
+#define XTH_XCVR_INSTANCES 1
+
 #define PS2D_RECV_STORAGE_SIZE 16
 #define PS2D_SEND_STORAGE_SIZE 64
 #define KEYEVENT_QUEUE_SIZE 10
 
+#ifdef USE_CONSOLE
+    /* Software UART, one bit per PS/2 transceiver interrupt, i.e.
+     * F_CPU / (8 * (OCR0A + 1)) = 8 MHz / (8 * 20) */
+    #define CONSOLE_BAUD_RATE 50000UL
+    #define CONSOLE_SEND_BUFFER_SIZE 48
+
+    /* The software UART needs Timer0 at full rate */
+    #define PS2D_XCVR_IDLE_MODE_DELAY 0
+
+    /* Console transmit on PB0 */
+    #define CONSOLE_TX_PORT PORTB
+    #define CONSOLE_TX_DDR  DDRB
+    #define CONSOLE_TX_BIT  0
+#endif
+
 /* Interrupt interval */
 #define SCHEDULER_INTERVAL 100 /* microseconds */
 #define SCHEDULER_MAX_TASKS 4
@@ -7,6 +7,10 @@ ifeq ($(USE_TYPEMATIC),yes)
 	OPT_DEFS += -DUSE_TYPEMATIC
 endif
 
+ifeq ($(USE_XT_SECOND_KBD),yes)
+	OPT_DEFS += -DUSE_XT_SECOND_KBD
+endif
+
 SRC_DIR   := $(MODULES)
 SRC       := $(foreach sdir,$(SRC_DIR),$(wildcard $(sdir)/*.c))
 SRC       += $(BOARDS_DIR)/$(CURR_DIR)/$(BOARD_SRC)
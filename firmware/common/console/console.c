@@ -17,12 +17,151 @@
 #ifdef USE_CONSOLE
 
 #include "console_hal.h"
+#include "atomic_hal.h"
 
 static uint8_t _sendQueueStorage[CONSOLE_SEND_BUFFER_SIZE]; //NOTE: Buffer must stay in RAM
-static CircularBuffer _sendQueue; /* Holds data received from the host */
+static CircularBuffer _sendQueue; /* Holds data to be sent, drained by the transmit ISR */
 CircularBuffer* consoleSendQueue;
 uint8_t severityFlags = 0;
 
+/* Number of messages dropped because the send queue was full, and the 
+ * count carried by the last marker */
+static uint16_t _dropCount = 0;
+static uint16_t _dropReported = 0;
+
+/* Sequence number of the next message, dropped messages consume a number
+ * so the host can detect the gap */
+static uint8_t _sequence = 0;
+
+/* Source of message timestamps and the tick count of the last message */
+static ConsoleTimestampSource _timestampSource = 0;
+static uint32_t _lastTick = 0;
+
+/* Largest delta encodable in CON_MSG_TIMESTAMP_MAX_LEN varint bytes */
+#define CON_TIMESTAMP_DELTA_MAX 0x1FFFFFUL
+
+/* Length of a marker, excluding its timestamp */
+#define CON_MARKER_LEN (CON_MSG_SYNC_LEN + CON_MSG_LEN_DATA16 + CON_MSG_SEQUENCE_LEN)
+
+/* Length of an absolute tick message, with its zero timestamp */
+#define CON_TICK_LEN (CON_MSG_LEN_DATA32 + CON_MSG_SEQUENCE_LEN + 1)
+
+/* ------------------------------------------------------------------------
+ *  Encode the ticks elapsed since the last message as a varint
+ *   - Deltas beyond 3 bytes (21 bits) are encoded as zero, the caller 
+ *     re-anchors the host with an absolute tick message
+ *   - Returns the number of bytes written
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static uint8_t EncodeTimestamp(uint8_t* out, uint32_t delta)
+{
+    uint8_t length = 0;
+
+    if (delta > CON_TIMESTAMP_DELTA_MAX)
+        delta = 0;
+
+    while (delta > 0x7F) {
+        out[length++] = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+    }
+    out[length++] = (uint8_t)delta;
+
+    return length;
+}
+
+/* ------------------------------------------------------------------------
+ *  Insert a message into the send queue, caller must ensure room
+ *   - Header, sequence number, timestamp then data
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void InsertMessage(const uint8_t* messageBytes, uint8_t length,
+                          const uint8_t* timestamp, uint8_t timestampLength)
+{
+    CircularBuffer_InsertBlock(&_sendQueue, messageBytes, CON_MSG_HEADER_LEN);
+    CircularBuffer_Insert(&_sendQueue, _sequence++);
+    CircularBuffer_InsertBlock(&_sendQueue, timestamp, timestampLength);
+    CircularBuffer_InsertBlock(&_sendQueue, messageBytes + CON_MSG_HEADER_LEN, length - CON_MSG_HEADER_LEN);
+}
+
+/* ------------------------------------------------------------------------
+ *  Insert a marker: the sync byte followed by a message reporting the 
+ *  total number of dropped messages. The host resynchronizes on markers.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void InsertMarker(const uint8_t* timestamp, uint8_t timestampLength)
+{
+    ConsoleMessage message;
+    message.sourceType = (uint8_t)(CON_SRC_CONSOLE << 4) | CON_MSG_DATA16;
+    message.messageId = CON_MSG_CONSOLE_DROPPED;
+    message.data.type16.data1 = _dropCount;
+
+    CircularBuffer_Insert(&_sendQueue, CON_MSG_SYNC);
+    InsertMessage(message.messageBytes, CON_MSG_LEN_DATA16, timestamp, timestampLength);
+    _dropReported = _dropCount;
+}
+
+/* ------------------------------------------------------------------------
+ *  Insert a message carrying the absolute tick count, sent in place of a
+ *  delta too large to encode so the host can re-anchor device time
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void InsertTick(uint32_t tick)
+{
+    static const uint8_t noDelay = 0;
+    ConsoleMessage message;
+    message.sourceType = (uint8_t)(CON_SRC_CONSOLE << 4) | CON_MSG_DATA32;
+    message.messageId = CON_MSG_CONSOLE_TICK;
+    message.data.type32.data1 = tick;
+
+    InsertMessage(message.messageBytes, CON_MSG_LEN_DATA32, &noDelay, 1);
+}
+
+/* ------------------------------------------------------------------------
+ *  Queue a message for transmission
+ *   - Messages are admitted whole or dropped and counted
+ *   - A marker precedes the first message after a drop and the message
+ *     starting each sequence number cycle
+ *   - An absolute tick message precedes a message whose delta is too
+ *     large to encode
+ *   - Transmit interrupt is enabled to drain the queue
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void QueueMessage(const uint8_t* messageBytes, uint8_t length)
+{
+    static const uint8_t noDelay = 0;
+    uint8_t timestamp[CON_MSG_TIMESTAMP_MAX_LEN];
+
+    ATOMIC_RESTORE() {
+        uint32_t tick = _timestampSource ? _timestampSource() : _lastTick;
+        uint8_t timestampLength = EncodeTimestamp(timestamp, tick - _lastTick);
+        bool anchor = (tick - _lastTick) > CON_TIMESTAMP_DELTA_MAX;
+        bool marker = (_dropCount != _dropReported) || (_sequence == 0) ||
+                      (anchor && _sequence == UINT8_MAX);
+        uint8_t required = length + CON_MSG_SEQUENCE_LEN + timestampLength;
+
+        if (marker)
+            required += CON_MARKER_LEN + 1;
+        if (anchor)
+            required += CON_TICK_LEN;
+
+        if (CircularBuffer_Size(&_sendQueue) - CircularBuffer_Count(&_sendQueue) >= required) {
+            const uint8_t* delay = timestamp;
+            uint8_t delayLength = timestampLength;
+
+            if (marker) {
+                /* The marker carries the delay, the messages follow it */
+                InsertMarker(delay, delayLength);
+                delay = &noDelay;
+                delayLength = 1;
+            }
+            if (anchor)
+                InsertTick(tick);
+            InsertMessage(messageBytes, length, delay, delayLength);
+            _lastTick = tick;
+            ConsoleHal_EnableXmitInterrupt();
+        } else {
+            if (_dropCount < UINT16_MAX)
+                _dropCount++;
+            _sequence++;
+        }
+    }
+}
+
 void Console_Init(ConsoleSeverity severity)
 {
     /* Initialize the internal send and receive queues */
@@ -36,26 +175,86 @@ void Console_Init(ConsoleSeverity severity)
     CONSOLE_SEND0(CON_SRC_CONSOLE, CON_SEV_TRACE_EVENT, CON_MSG_CONSOLE_START);
 }
 
+/* ------------------------------------------------------------------------
+ *  Transmission is handled by the transmit ISR and drops are reported by
+ *  markers as messages are queued.
+ *   - Drops not yet reported, e.g. at the end of a burst with no message
+ *     following, are reported by a marker once the queue has room
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Console_Update(void)
 {
-    if (CircularBuffer_IsEmpty(&_sendQueue))
-        return;
+    uint8_t timestamp[CON_MSG_TIMESTAMP_MAX_LEN];
 
-    uint8_t data = CircularBuffer_Peek(&_sendQueue);
+    ATOMIC_RESTORE() {
+        if (_dropCount != _dropReported) {
+            uint32_t tick = _timestampSource ? _timestampSource() : _lastTick;
+            uint8_t timestampLength = EncodeTimestamp(timestamp, tick - _lastTick);
+            bool anchor = (tick - _lastTick) > CON_TIMESTAMP_DELTA_MAX;
+            uint8_t required = CON_MARKER_LEN + timestampLength;
 
-    if (ConsoleHal_TrySend(data))
-        CircularBuffer_Remove(&_sendQueue);
+            if (anchor)
+                required += CON_TICK_LEN;
 
+            if (CircularBuffer_Size(&_sendQueue) - CircularBuffer_Count(&_sendQueue) >= required) {
+                InsertMarker(timestamp, timestampLength);
+                if (anchor)
+                    InsertTick(tick);
+                _lastTick = tick;
+                ConsoleHal_EnableXmitInterrupt();
+            }
+        }
+    }
 }
 
+/* ------------------------------------------------------------------------
+ *  Send all queued data by polling. Usable with interrupts disabled.
+ *   - Each byte is taken from the queue atomically, a software UART 
+ *     frame is then completed outside the atomic block so interrupts 
+ *     run between bytes
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Console_Flush(void)
 {
-    while (!CircularBuffer_IsEmpty(&_sendQueue))
+    bool empty = false;
+
+    while (!empty)
     {
-        uint8_t data = CircularBuffer_Remove(&_sendQueue);
-        while(!ConsoleHal_TrySend(data));
+        ATOMIC_RESTORE() {
+            if (!CircularBuffer_IsEmpty(&_sendQueue) &&
+                ConsoleHal_TrySend(CircularBuffer_Peek(&_sendQueue))) {
+                CircularBuffer_Remove(&_sendQueue);
+            }
+            empty = CircularBuffer_IsEmpty(&_sendQueue);
+        }
+
+        ConsoleHal_CompleteSend();
+    }
+}
+
+uint16_t Console_DropCount(void)
+{
+    uint16_t dropCount;
+
+    ATOMIC_RESTORE() {
+        dropCount = _dropCount;
     }
 
+    return dropCount;
+}
+
+/* ------------------------------------------------------------------------
+ *  Set the tick source used to timestamp messages
+ *   - The tick period is reported so the host can convert ticks to time
+ *   - Deltas count from tick zero, so host time matches the absolute 
+ *     tick messages
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void Console_SetTimestampSource(ConsoleTimestampSource source, uint16_t tickPeriod)
+{
+    ATOMIC_RESTORE() {
+        _timestampSource = source;
+        _lastTick = 0;
+    }
+
+    CONSOLE_SEND16(CON_SRC_CONSOLE, CON_SEV_TRACE_EVENT, CON_MSG_CONSOLE_TICK_PERIOD, tickPeriod);
 }
 
 bool Console_PowerDetected(void)
@@ -69,7 +268,7 @@ void Console_Send0(ConsoleSource source, ConsoleSeverity severity, uint8_t messa
     ConsoleMessage message;
     message.sourceType = (uint8_t)(source << 4) | CON_MSG_DATA0;
     message.messageId = messageId;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA0);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA0);
 }
 
 void Console_Send8(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint8_t data)
@@ -78,7 +277,7 @@ void Console_Send8(ConsoleSource source, ConsoleSeverity severity, uint8_t messa
     message.sourceType = (uint8_t)(source << 4) | CON_MSG_DATA8;
     message.messageId = messageId;
     message.data.type8.data1 = data;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA8);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA8);
 }
 
 void Console_Send88(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint8_t data1, uint8_t data2)
@@ -88,7 +287,7 @@ void Console_Send88(ConsoleSource source, ConsoleSeverity severity, uint8_t mess
     message.messageId = messageId;
     message.data.type8.data1 = data1;
     message.data.type88.data2 = data2;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA88);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA88);
 }
 
 void Console_Send888(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint8_t data1, uint8_t data2, uint8_t data3)
@@ -99,7 +298,7 @@ void Console_Send888(ConsoleSource source, ConsoleSeverity severity, uint8_t mes
     message.data.type888.data1 = data1;
     message.data.type888.data2 = data2;
     message.data.type888.data3 = data3;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA888);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA888);
 }
 
 void Console_Send8888(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint8_t data1, uint8_t data2, uint8_t data3, uint8_t data4)
@@ -111,7 +310,7 @@ void Console_Send8888(ConsoleSource source, ConsoleSeverity severity, uint8_t me
     message.data.type8888.data2 = data2;
     message.data.type8888.data3 = data3;
     message.data.type8888.data4 = data4;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA8888);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA8888);
 }
 
 void Console_Send16(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId,  uint16_t data)
@@ -120,17 +319,17 @@ void Console_Send16(ConsoleSource source, ConsoleSeverity severity, uint8_t mess
     message.sourceType = (uint8_t)(source << 4) | CON_MSG_DATA16;
     message.messageId = messageId;
     message.data.type16.data1 = data;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA16);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA16);
 }
 
 void Console_Send1616(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint16_t data1, uint16_t data2)
 {
     ConsoleMessage message;
-    message.sourceType = (uint8_t)(source << 4) | CON_MSG_DATA16;
+    message.sourceType = (uint8_t)(source << 4) | CON_MSG_DATA1616;
     message.messageId = messageId;
     message.data.type1616.data1 = data1;
     message.data.type1616.data2 = data2;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA1616);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA1616);
 }
 
 void Console_Send32(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint32_t data)
@@ -139,7 +338,7 @@ void Console_Send32(ConsoleSource source, ConsoleSeverity severity, uint8_t mess
     message.sourceType = (uint8_t)(source << 4) | CON_MSG_DATA32;
     message.messageId = messageId;
     message.data.type32.data1 = data;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA32);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA32);
 }
 
 void Console_Send816(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint8_t data1, uint16_t data2)
@@ -149,7 +348,7 @@ void Console_Send816(ConsoleSource source, ConsoleSeverity severity, uint8_t mes
     message.messageId = messageId;
     message.data.type816.data1 = data1;
     message.data.type816.data2 = data2;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA816);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA816);
 }
 
 void Console_Send8816(ConsoleSource source, ConsoleSeverity severity, uint8_t messageId, uint8_t data1, uint8_t data2, uint16_t data3)
@@ -160,7 +359,34 @@ void Console_Send8816(ConsoleSource source, ConsoleSeverity severity, uint8_t me
     message.data.type8816.data1 = data1;
     message.data.type8816.data2 = data2;
     message.data.type8816.data3 = data3;
-    CircularBuffer_InsertBlock(consoleSendQueue, message.messageBytes, CON_MSG_LEN_DATA8816);
+    QueueMessage(message.messageBytes, CON_MSG_LEN_DATA8816);
+}
+
+/* ------------------------------------------------------------------------
+ *  Transmit ISR
+ *   - Sends the next queued byte while the queue holds data
+ *   - Disables itself once the queue is empty
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+CONSOLE_XMIT_ISR()
+{
+    if (CircularBuffer_IsEmpty(&_sendQueue)) {
+        ConsoleHal_DisableXmitInterrupt();
+    } else {
+        ConsoleHal_WriteData(CircularBuffer_Remove(&_sendQueue));
+    }
+}
+
+#ifdef CONSOLE_BIT_ISR
+/* ------------------------------------------------------------------------
+ *  Software UART bit ISR
+ *   - Shifts out one bit of the current frame
+ *   - Runs the transmit ISR once the frame is complete
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+CONSOLE_BIT_ISR()
+{
+    if (ConsoleHal_ShiftBit())
+        ConsoleHal_XmitIsr();
 }
+#endif
 
 #endif
\ No newline at end of file
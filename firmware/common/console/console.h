@@ -34,11 +34,20 @@ typedef enum _ConsoleSeverity
 typedef enum _ConsoleMessageId
 {
 	CON_MSG_CONSOLE_START,
+	CON_MSG_CONSOLE_DROPPED,
+	CON_MSG_CONSOLE_TICK_PERIOD,
+	CON_MSG_CONSOLE_TICK,
 } ConsoleMessageId;
 
+/* Provides the tick count used to timestamp messages. Called with 
+ * interrupts disabled. */
+typedef uint32_t (*ConsoleTimestampSource)(void);
+
 
 #ifdef USE_CONSOLE
 
+#include "console_config.h"
+
 extern CircularBuffer* consoleSendQueue;
 extern uint8_t severityFlags;
 
@@ -46,6 +55,8 @@ void Console_Init(ConsoleSeverity severity);
 void Console_Update(void);
 void Console_Flush(void);
 bool Console_PowerDetected(void);
+uint16_t Console_DropCount(void);
+void Console_SetTimestampSource(ConsoleTimestampSource source, uint16_t tickPeriod);
 
 static inline void Console_SeveritySet(ConsoleSeverity severity)
 {
@@ -65,18 +76,25 @@ void Console_Send8816(ConsoleSource source, ConsoleSeverity severity, uint8_t me
 
 
 
+/* A message is sent only if its severity is enabled for its source at
+ * compile time and in the runtime severity flags */
+#define CONSOLE_SEVERITY_ENABLED(source, severity) \
+	((CONSOLE_SOURCE_SEVERITY_MASK(source) & (severity)) && (severityFlags & (severity)))
+
 #define CONSOLE_SEND0(source, severity, messageId) do { \
-	if (severityFlags & severity) Console_Send0(source, severity, messageId); } while(0);
+	if (CONSOLE_SEVERITY_ENABLED(source, severity)) Console_Send0(source, severity, messageId); } while(0);
 #define CONSOLE_SEND8(source, severity, messageId, data) do { \
-	if (severityFlags & severity) Console_Send8(source, severity, messageId, data); } while(0);
+	if (CONSOLE_SEVERITY_ENABLED(source, severity)) Console_Send8(source, severity, messageId, data); } while(0);
 #define CONSOLE_SEND88(source, severity, messageId, data1, data2) do { \
-	if (severityFlags & severity) Console_Send88(source, severity, messageId, data1, data2); } while(0);
+	if (CONSOLE_SEVERITY_ENABLED(source, severity)) Console_Send88(source, severity, messageId, data1, data2); } while(0);
 #define CONSOLE_SEND888(source, severity, messageId, data1, data2, data3) do { \
-	if (severityFlags & severity) Console_Send888(source, severity, messageId, data1, data2, data3); } while(0);
+	if (CONSOLE_SEVERITY_ENABLED(source, severity)) Console_Send888(source, severity, messageId, data1, data2, data3); } while(0);
+#define CONSOLE_SEND8888(source, severity, messageId, data1, data2, data3, data4) do { \
+	if (CONSOLE_SEVERITY_ENABLED(source, severity)) Console_Send8888(source, severity, messageId, data1, data2, data3, data4); } while(0);
 #define CONSOLE_SEND16(source, severity, messageId, data) do { \
-	if (severityFlags & severity) Console_Send16(source, severity, messageId, data); } while(0);
+	if (CONSOLE_SEVERITY_ENABLED(source, severity)) Console_Send16(source, severity, messageId, data); } while(0);
 #define CONSOLE_SEND1616(source, severity, messageId, data1, data2) do { \
-	if (severityFlags & severity) Console_Send1616(source, severity, messageId, data1, data2); } while(0);
+	if (CONSOLE_SEVERITY_ENABLED(source, severity)) Console_Send1616(source, severity, messageId, data1, data2); } while(0);
 
 #else
 
@@ -84,11 +102,14 @@ static inline void Console_Init(ConsoleSeverity severity) { (void)severity; }
 static inline void Console_Update(void) {}
 static inline void Console_Flush(void) {}
 static inline bool Console_PowerDetected(void) { return true;}
+static inline uint16_t Console_DropCount(void) { return 0; }
+static inline void Console_SetTimestampSource(ConsoleTimestampSource source, uint16_t tickPeriod) { (void)source; (void)tickPeriod; }
 
 #define CONSOLE_SEND0(source, severity, messageId)
 #define CONSOLE_SEND8(source, severity, messageId, data)
 #define CONSOLE_SEND88(source, severity, messageId, data1, data2)
 #define CONSOLE_SEND888(source, severity, messageId, data1, data2, data3)
+#define CONSOLE_SEND8888(source, severity, messageId, data1, data2, data3, data4)
 #define CONSOLE_SEND16(source, severity, messageId, data)
 #define CONSOLE_SEND1616(source, severity, messageId, data1, data2)
 
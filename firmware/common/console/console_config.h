@@ -0,0 +1,71 @@
+/* =======================================================================
+ * console_config.h
+ *
+ * Purpose:
+ *  Defines application specific values used to configure the console.
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+
+#ifndef CONSOLE_CONFIG_H_
+#define CONSOLE_CONFIG_H_
+
+#include "config.h"
+
+/* Compile time severity masks. CONSOLE_SEND call sites whose severity is
+ * not in the mask for their source compile to nothing. The runtime 
+ * severity set by Console_Init further filters the remaining call sites.
+ * CONSOLE_SEVERITY_MASK is the default for every source. */
+#ifndef CONSOLE_SEVERITY_MASK
+    #define CONSOLE_SEVERITY_MASK 0xFF
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_CONSOLE
+    #define CONSOLE_SEVERITY_MASK_CONSOLE CONSOLE_SEVERITY_MASK
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_XTH_XCVR
+    #define CONSOLE_SEVERITY_MASK_XTH_XCVR CONSOLE_SEVERITY_MASK
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_XTH_KBD
+    #define CONSOLE_SEVERITY_MASK_XTH_KBD CONSOLE_SEVERITY_MASK
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_PS2D_XCVR
+    #define CONSOLE_SEVERITY_MASK_PS2D_XCVR CONSOLE_SEVERITY_MASK
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_PS2D_KBD
+    #define CONSOLE_SEVERITY_MASK_PS2D_KBD CONSOLE_SEVERITY_MASK
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_XT2PS2
+    #define CONSOLE_SEVERITY_MASK_XT2PS2 CONSOLE_SEVERITY_MASK
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_KEYMAP
+    #define CONSOLE_SEVERITY_MASK_KEYMAP CONSOLE_SEVERITY_MASK
+#endif
+
+#ifndef CONSOLE_SEVERITY_MASK_TEST
+    #define CONSOLE_SEVERITY_MASK_TEST CONSOLE_SEVERITY_MASK
+#endif
+
+/* Mask for a source, constant folded when source is a constant */
+#define CONSOLE_SOURCE_SEVERITY_MASK(source) ( \
+    (source) == CON_SRC_CONSOLE   ? (CONSOLE_SEVERITY_MASK_CONSOLE)   : \
+    (source) == CON_SRC_XTH_XCVR  ? (CONSOLE_SEVERITY_MASK_XTH_XCVR)  : \
+    (source) == CON_SRC_XTH_KBD   ? (CONSOLE_SEVERITY_MASK_XTH_KBD)   : \
+    (source) == CON_SRC_PS2D_XCVR ? (CONSOLE_SEVERITY_MASK_PS2D_XCVR) : \
+    (source) == CON_SRC_PS2D_KBD  ? (CONSOLE_SEVERITY_MASK_PS2D_KBD)  : \
+    (source) == CON_SRC_XT2PS2    ? (CONSOLE_SEVERITY_MASK_XT2PS2)    : \
+    (source) == CON_SRC_KEYMAP    ? (CONSOLE_SEVERITY_MASK_KEYMAP)    : \
+    (source) == CON_SRC_TEST      ? (CONSOLE_SEVERITY_MASK_TEST)      : \
+    (CONSOLE_SEVERITY_MASK))
+
+#endif /* CONSOLE_CONFIG_H_ */
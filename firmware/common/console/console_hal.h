@@ -20,9 +20,16 @@ static inline void ConsoleHal_Init(void);
 
 static inline bool ConsoleHal_TrySend(uint8_t data);
 static inline bool ConsoleHal_Send(uint8_t data);
+static inline void ConsoleHal_CompleteSend(void);
 
 static inline bool ConsoleHal_PowerDetected(void);
 
+/* Interrupt driven transmit. The transmit ISR is invoked while transmit
+ * interrupts are enabled and the transmit data register is empty */
+static inline void ConsoleHal_EnableXmitInterrupt(void);
+static inline void ConsoleHal_DisableXmitInterrupt(void);
+static inline void ConsoleHal_WriteData(uint8_t data);
+
 /* Include the appropriate HAL implementation */
 #if ARCH == AVR8
 #include "console_hal_avr.h"
@@ -30,6 +37,11 @@ static inline bool ConsoleHal_PowerDetected(void);
 #error No HAL implementation for Console defined.
 #endif
 
+/* Ensure that the HAL implementation has defined the ISRs */
+#if !defined(CONSOLE_XMIT_ISR)
+    #error CONSOLE_XMIT_ISR not defined.
+#endif
+
 
 
 #endif /* CONSOLE_HAL_H_ */
\ No newline at end of file
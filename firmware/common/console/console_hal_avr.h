@@ -3,10 +3,24 @@
  *
  * Purpose:
  *  Implementation of the HAL for the console subsystem for AVR 
- *  devices. Uses Timer0
+ *  devices. 
  *  Currently supports:
- *    ATTiny85
- *    ATMega88
+ *    ATMega328P - USART0
+ *    ATMega32U4 - USART1
+ *    ATTiny85   - Transmit only software UART on CONSOLE_TX_BIT
+ *
+ *  Software UART:
+ *   The ATtiny85 has no USART. Bits are shifted out by the Timer0 Compare
+ *   Match B interrupt. Timer0 is run in CTC mode by the PS/2 transceiver,
+ *   so the bit rate is the PS/2 transceiver interrupt rate and compare 
+ *   match B is placed half way between PS/2 interrupts to keep the two 
+ *   ISRs from delaying each other. The bit ISR writes the output pin 
+ *   before doing anything else so bit edges do not jitter. A completed 
+ *   frame is followed by one idle bit while the next byte is loaded.
+ *   The bit period is the Timer0 period, PS2D_XCVR_TIMER_PRESCALER * 
+ *   (OCR0A + 1) cycles, and CONSOLE_BAUD_RATE is checked against it.
+ *   Console_Flush bit-bangs each byte with busy waits timed to the same
+ *   period, interrupts are disabled for one frame at a time.
  *
  * License:
  *  Copyright (c) 2015, Engicoder
@@ -25,6 +39,72 @@
 
 #define CONSOLE_SEND_ATTEMPTS 100
 
+#if defined (__AVR_ATtiny85__)
+#include <util/delay.h>
+
+#if !defined(CONSOLE_TX_PORT) || !defined(CONSOLE_TX_DDR) || !defined(CONSOLE_TX_BIT)
+    #error CONSOLE_TX_PORT, CONSOLE_TX_DDR and CONSOLE_TX_BIT must be defined for the software UART.
+#endif
+
+#include "ps2d_xcvr_hal.h"
+
+/* One bit per Timer0 compare match */
+#define CONSOLE_BIT_CYCLES PS2D_XCVR_TICK_CYCLES
+#define CONSOLE_TIMER_BAUD_RATE (F_CPU / CONSOLE_BIT_CYCLES)
+
+#ifndef CONSOLE_BAUD_RATE
+    #define CONSOLE_BAUD_RATE CONSOLE_TIMER_BAUD_RATE
+#endif
+
+#if CONSOLE_BAUD_RATE * 50UL < CONSOLE_TIMER_BAUD_RATE * 49UL || CONSOLE_BAUD_RATE * 50UL > CONSOLE_TIMER_BAUD_RATE * 51UL
+    #error "CONSOLE_BAUD_RATE must be within 2% of F_CPU / (PS2D_XCVR_TIMER_PRESCALER * (OCR0A + 1))."
+#endif
+
+/* Busy wait of a bit-banged bit, less the approximate cycles taken by
+ * the rest of the bit loop */
+#define CONSOLE_BIT_LOOP_CYCLES 12UL
+#define CONSOLE_BIT_DELAY_US ((CONSOLE_BIT_CYCLES - CONSOLE_BIT_LOOP_CYCLES) * 1000000.0 / F_CPU)
+
+/* Start bit, 8 data bits LSB first, stop bit and a terminating 1 that 
+ * leaves the shift register holding 1 when the frame is complete */
+#define CONSOLE_FRAME(data) ((((uint16_t)(data)) << 1) | 0x0600)
+
+static volatile uint16_t _consoleTxShift = 1;
+static volatile bool _consoleXmitEnabled = false;
+
+static inline void ConsoleHal_WriteTxBit(uint16_t shift)
+{
+    if (shift & 0x01)
+        CONSOLE_TX_PORT |= (1 << CONSOLE_TX_BIT);
+    else
+        CONSOLE_TX_PORT &= ~(1 << CONSOLE_TX_BIT);
+}
+
+/* Bit-bang the rest of the current frame with busy waits. Interrupts are
+ * disabled for the frame only, so pending interrupts run between bytes.
+ * Continues from the bit reached if the bit ISR has started the frame. */
+static inline void ConsoleHal_CompleteSend(void)
+{
+    uint8_t sreg = SREG;
+    cli();
+
+    uint16_t shift = _consoleTxShift;
+
+    while (shift > 1) {
+        ConsoleHal_WriteTxBit(shift);
+        shift >>= 1;
+        _delay_us(CONSOLE_BIT_DELAY_US);
+    }
+    _consoleTxShift = 1;
+
+    SREG = sreg;
+}
+#else
+static inline void ConsoleHal_CompleteSend(void)
+{
+}
+#endif
+
 static inline void ConsoleHal_Init(void)
 {
 #if defined (__AVR_ATmega328P__)
@@ -46,6 +126,12 @@ static inline void ConsoleHal_Init(void)
     /* Set data format to 8 data bits, 1 stop bit */
     UCSR1C = (1 << UCSZ10) | (1 << UCSZ11);
 
+#elif defined (__AVR_ATtiny85__)
+    /* Idle the transmit line high */
+    CONSOLE_TX_PORT |= (1 << CONSOLE_TX_BIT);
+    CONSOLE_TX_DDR  |= (1 << CONSOLE_TX_BIT);
+    _consoleTxShift = 1;
+
 #else
     #error UART console not supported for this mcu.
 #endif
@@ -70,6 +156,11 @@ static inline bool ConsoleHal_TrySend(uint8_t data)
     if (UCSR1A & (1 << UDRE1)) 
     {
         UDR1 = data;        
+#elif defined (__AVR_ATtiny85__)
+    /* Claims the shift register, ConsoleHal_CompleteSend() sends it */
+    if (_consoleTxShift <= 1) 
+    {
+        _consoleTxShift = CONSOLE_FRAME(data);
 #endif
         return true;
     }
@@ -83,6 +174,8 @@ static inline bool ConsoleHal_Send(uint8_t data)
     while(((UCSR0A & (1 << UDRE0)) == 0)
 #elif defined (__AVR_ATmega32U4__)
     while(((UCSR1A & (1 << UDRE1)) == 0)
+#elif defined (__AVR_ATtiny85__)
+    while((_consoleTxShift > 1)
 #endif
           && (timeout > 0)) {
         timeout--;
@@ -93,6 +186,9 @@ static inline bool ConsoleHal_Send(uint8_t data)
         UDR0 = data;        
 #elif defined (__AVR_ATmega32U4__)
         UDR1 = data;        
+#elif defined (__AVR_ATtiny85__)
+        _consoleTxShift = CONSOLE_FRAME(data);
+        ConsoleHal_CompleteSend();
 #endif
         return true;
     }
@@ -100,6 +196,68 @@ static inline bool ConsoleHal_Send(uint8_t data)
     
 }
 
+static inline void ConsoleHal_EnableXmitInterrupt(void)
+{
+#if defined (__AVR_ATmega328P__)
+    UCSR0B |= (1 << UDRIE0);
+#elif defined (__AVR_ATmega32U4__)
+    UCSR1B |= (1 << UDRIE1);
+#elif defined (__AVR_ATtiny85__)
+    _consoleXmitEnabled = true;
+
+    /* Place the bit interrupt half way between PS/2 transceiver interrupts */
+    OCR0B = OCR0A >> 1;
+    TIMSK |= (1 << OCIE0B);
+#endif
+}
+
+static inline void ConsoleHal_DisableXmitInterrupt(void)
+{
+#if defined (__AVR_ATmega328P__)
+    UCSR0B &= ~(1 << UDRIE0);
+#elif defined (__AVR_ATmega32U4__)
+    UCSR1B &= ~(1 << UDRIE1);
+#elif defined (__AVR_ATtiny85__)
+    /* The bit interrupt is disabled once the current frame completes */
+    _consoleXmitEnabled = false;
+#endif
+}
+
+/* Write to the transmit data register, only valid from the transmit ISR
+ * or after the data register has been found empty */
+static inline void ConsoleHal_WriteData(uint8_t data)
+{
+#if defined (__AVR_ATmega328P__)
+    UDR0 = data;
+#elif defined (__AVR_ATmega32U4__)
+    UDR1 = data;
+#elif defined (__AVR_ATtiny85__)
+    _consoleTxShift = CONSOLE_FRAME(data);
+#endif
+}
+
+#if defined (__AVR_ATtiny85__)
+/* Shift out the next bit of the current frame. Returns true when the 
+ * frame is complete and the transmit ISR should supply the next byte */
+static inline bool ConsoleHal_ShiftBit(void)
+{
+    uint16_t shift = _consoleTxShift;
+
+    if (shift > 1) {
+        ConsoleHal_WriteTxBit(shift);
+        _consoleTxShift = shift >> 1;
+        return false;
+    }
+
+    if (!_consoleXmitEnabled) {
+        TIMSK &= ~(1 << OCIE0B);
+        return false;
+    }
+
+    return true;
+}
+#endif
+
 static inline bool ConsoleHal_PowerDetected(void)
 {
 #ifdef CONSOLE_POWER_DETECT_PORT
@@ -109,4 +267,15 @@ static inline bool ConsoleHal_PowerDetected(void)
 #endif
 }
 
+/* Definition of transmit data register empty interrupt vector */
+#if defined (__AVR_ATmega328P__)
+    #define CONSOLE_XMIT_ISR() ISR(USART_UDRE_vect)
+#elif defined (__AVR_ATmega32U4__)
+    #define CONSOLE_XMIT_ISR() ISR(USART1_UDRE_vect)
+#elif defined (__AVR_ATtiny85__)
+    /* Transmit handler called from the software UART bit ISR */
+    #define CONSOLE_XMIT_ISR() static void ConsoleHal_XmitIsr(void)
+    #define CONSOLE_BIT_ISR() ISR(TIMER0_COMPB_vect)
+#endif
+
 #endif /* CONSOLE_HAL_AVR_H_ */
\ No newline at end of file
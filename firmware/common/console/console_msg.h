@@ -46,6 +46,26 @@ typedef enum _ConsoleMessageLength
 	CON_MSG_LEN_DATA8816 = 6,
 }_ConsoleMessageLength;
 
+/* Wire format of a message:
+ *   sourceType, messageId, sequence, timestamp, data
+ * The sequence number increments for every message, including messages
+ * dropped by the device. The timestamp is the ticks elapsed since the 
+ * previous message as a varint: 7 bits per byte, least significant group
+ * first, bit 7 set on all but the last byte. Lengths above exclude the 
+ * sequence number and timestamp, so each message costs its length plus
+ * the sequence byte and 1 to 3 timestamp bytes. A delta too large for 3
+ * bytes is sent as zero, preceded by a CON_MSG_CONSOLE_TICK message 
+ * carrying the absolute tick count.
+ *
+ * A marker is the sync byte followed by a CON_MSG_CONSOLE_DROPPED message
+ * carrying the total dropped count. The sync byte is never a valid 
+ * sourceType, so the host can resynchronize on it. */
+#define CON_MSG_HEADER_LEN 2
+#define CON_MSG_SEQUENCE_LEN 1
+#define CON_MSG_TIMESTAMP_MAX_LEN 3
+#define CON_MSG_SYNC 0xFF
+#define CON_MSG_SYNC_LEN 1
+
 typedef struct _ConsoleMessageData
 {
  	union
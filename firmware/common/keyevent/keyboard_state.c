@@ -0,0 +1,27 @@
+/* =======================================================================
+ * keyboard_state.c
+ *
+ * Purpose:
+ *  Modifier, lock and pressed key state of the keyboard as seen by the
+ *  host.
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+#include "keyboard_state.h"
+
+ModifierStatus _keyboardModifiers = MODIFIER_STATUS_NONE;
+LedStatus _keyboardLocks;
+
+static uint8_t _pressedStorage[BIT_ARRAY_STORAGE_SIZE(KEY_CODE_COUNT)];
+BitArray _keyboardPressed = { _pressedStorage, sizeof(_pressedStorage) };
+
+void KeyboardState_Reset(void)
+{
+    ModifierStatus_Clear(&_keyboardModifiers);
+    _keyboardLocks = 0;
+    BitArray_ClearAll(&_keyboardPressed);
+}
@@ -0,0 +1,161 @@
+/* =======================================================================
+ * keyboard_state.h
+ *
+ * Purpose:
+ *  Modifier, lock and pressed key state of the keyboard as seen by the
+ *  host.
+ *
+ * Operational Summary:
+ *  The state is updated once for every KeyEvent sent to the host and
+ *  from the lock LED state set by the host. Consumers, e.g. the keymap
+ *  and the scan code converters, query it rather than tracking the
+ *  modifiers themselves. The pressed keys are kept in a bit array
+ *  indexed by KeyCode so their releases can be sent when the mapping
+ *  of held keys changes.
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+
+#ifndef KEYBOARD_STATE_H_
+#define KEYBOARD_STATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "keyevent.h"
+#include "modifier_status.h"
+#include "led_status.h"
+#include "bit_array.h"
+
+extern ModifierStatus _keyboardModifiers;
+extern LedStatus _keyboardLocks;
+extern BitArray _keyboardPressed;
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Clears the modifier, lock and pressed key state.
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void KeyboardState_Reset(void);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Updates the modifier and pressed key state. Must be called once for
+ *  each KeyEvent sent to the host.
+ *
+ * Parameters:
+ *  keyEvent - the KeyEvent sent to the host
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void KeyboardState_OnKeyEvent(KeyEvent* keyEvent)
+{
+    ModifierStatus_Update(&_keyboardModifiers, keyEvent);
+
+    if (KeyEvent_IsPress(keyEvent))
+        BitArray_SetBit(&_keyboardPressed, KeyEvent_Code(keyEvent));
+    else
+        BitArray_ClearBit(&_keyboardPressed, KeyEvent_Code(keyEvent));
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Sets the lock state from the LED state set by the host.
+ *
+ * Parameters:
+ *  locks - lock LEDs that are on
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void KeyboardState_SetLocks(LedStatus locks)
+{
+    _keyboardLocks = locks;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if all of the specified modifiers are down.
+ *
+ * Parameters:
+ *  modifiers - the modifiers to check
+ *
+ * Returns: bool
+ *   true  - if all of the modifiers are down
+ *   false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline bool KeyboardState_AllDown(Modifiers modifiers)
+{
+    return ModifierStatus_IsDown(&_keyboardModifiers, modifiers);
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if any of the specified modifiers is down, e.g. either
+ *  shift key.
+ *
+ * Parameters:
+ *  modifiers - the modifiers to check
+ *
+ * Returns: bool
+ *   true  - if any of the modifiers is down
+ *   false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline bool KeyboardState_AnyDown(Modifiers modifiers)
+{
+    return (_keyboardModifiers.Mods & modifiers) != 0;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if no modifier is down.
+ *
+ * Returns: bool
+ *   true  - if no modifier is down
+ *   false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline bool KeyboardState_NoneDown(void)
+{
+    return ModifierStatus_None(&_keyboardModifiers);
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if a lock is on.
+ *
+ * Parameters:
+ *  lock - the lock to check, e.g. LedStatusNumLock
+ *
+ * Returns: bool
+ *   true  - if the lock is on
+ *   false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline bool KeyboardState_IsLockOn(LedStatus lock)
+{
+    return (_keyboardLocks & lock) != 0;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if a key has been pressed and not yet released.
+ *
+ * Parameters:
+ *  keyCode - the key to check
+ *
+ * Returns: bool
+ *   true  - if the key is pressed
+ *   false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline bool KeyboardState_IsPressed(KeyCode keyCode)
+{
+    return BitArray_IsSet(&_keyboardPressed, keyCode);
+}
+
+#endif /* KEYBOARD_STATE_H_ */
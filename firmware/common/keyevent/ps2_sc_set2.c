@@ -22,7 +22,7 @@
 #include "keyevent.h"
 #include "byte_sequence.h"
 #include "ps2_sc_set2.h"
-#include "modifier_status.h"
+#include "keyboard_state.h"
 
 
 
@@ -405,7 +405,66 @@ const uint8_t* const _miscMap[] PROGMEM =
     PGM_SET2_CD_PREV_TRK ,
 };
 
-const uint8_t PROGMEM PGM_SET2_PRTSC_SHIFT  [] = { 0x04, 0xE0, 0x12, 0xE0, 0x7C,};
+/* Complete make and break sequences of the keys whose codes depend on the
+ * modifiers down, as sent by an IBM enhanced keyboard. Fake shift and ctrl
+ * codes are included so the host sees the key it expects. The length 
+ * prefix is computed from the codes. */
+#define SET2_SPECIAL_SEQUENCE(name, ...) \
+    const uint8_t PROGMEM name[] = { sizeof((const uint8_t[]){ __VA_ARGS__ }), __VA_ARGS__ }
+
+const uint8_t PROGMEM PGM_SET2_SPECIAL_NONE       [] = { 0x00, };
+SET2_SPECIAL_SEQUENCE(PGM_SET2_PRTSC_MAKE,          0xE0, 0x12, 0xE0, 0x7C);
+SET2_SPECIAL_SEQUENCE(PGM_SET2_PRTSC_BREAK,         0xE0, 0xF0, 0x7C, 0xE0, 0xF0, 0x12);
+SET2_SPECIAL_SEQUENCE(PGM_SET2_PRTSC_MOD_BREAK,     0xE0, 0xF0, 0x7C);
+SET2_SPECIAL_SEQUENCE(PGM_SET2_SYSREQ_BREAK,        0xF0, 0x84);
+SET2_SPECIAL_SEQUENCE(PGM_SET2_PAUSE_LCTRL_MAKE,    0xF0, 0x14,
+                                                    0xE1, 0x14, 0x77, 0xE1, 0xF0, 0x14, 0xF0, 0x77,
+                                                    0x14);
+SET2_SPECIAL_SEQUENCE(PGM_SET2_PAUSE_RCTRL_MAKE,    0xE0, 0xF0, 0x14,
+                                                    0xE1, 0x14, 0x77, 0xE1, 0xF0, 0x14, 0xF0, 0x77,
+                                                    0xE0, 0x14);
+SET2_SPECIAL_SEQUENCE(PGM_SET2_CTRL_BREAK_MAKE,     0xE0, 0x7E, 0xE0, 0xF0, 0x7E);
+SET2_SPECIAL_SEQUENCE(PGM_SET2_BREAK_FAKE_CTRL,     0x14,
+                                                    0xE0, 0x7E, 0xE0, 0xF0, 0x7E,
+                                                    0xF0, 0x14);
+
+typedef struct _Set2SpecialKey
+{
+    uint8_t        code;        /* KeyCode */
+    uint8_t        modifiers;   /* Any of these must be down, MODS_NONE always matches */
+    const uint8_t* make;
+    const uint8_t* brk;
+} Set2SpecialKey;
+
+/* Searched in order on make, the first entry matching the KeyCode and 
+ * modifiers is used and latched for the release. Pause and Break are make
+ * only, nothing is sent on release.
+ *  - PrintScreen: fake shift unless shift or ctrl is down, SysRq with alt
+ *  - Pause: a ctrl down is a combination mapped by the keymap, e.g.
+ *    ctrl + NumLock on XT keyboards, so ctrl is released around the
+ *    Pause sequence to stop the host from seeing Break
+ *  - Break: fake ctrl unless ctrl is down */
+static const Set2SpecialKey _specialKeys[] PROGMEM =
+{
+    { KC_PRINT_SCREEN, MODS_LALT | MODS_RALT,                                PGM_SET2_SYSREQ,            PGM_SET2_SYSREQ_BREAK     },
+    { KC_PRINT_SCREEN, MODS_LSHIFT | MODS_RSHIFT | MODS_LCTRL | MODS_RCTRL,  PGM_SET2_PRINT_SCREEN,      PGM_SET2_PRTSC_MOD_BREAK  },
+    { KC_PRINT_SCREEN, MODS_NONE,                                            PGM_SET2_PRTSC_MAKE,        PGM_SET2_PRTSC_BREAK      },
+    { KC_SYSREQ,       MODS_NONE,                                            PGM_SET2_SYSREQ,            PGM_SET2_SYSREQ_BREAK     },
+    { KC_PAUSE,        MODS_LCTRL,                                           PGM_SET2_PAUSE_LCTRL_MAKE,  PGM_SET2_SPECIAL_NONE     },
+    { KC_PAUSE,        MODS_RCTRL,                                           PGM_SET2_PAUSE_RCTRL_MAKE,  PGM_SET2_SPECIAL_NONE     },
+    { KC_PAUSE,        MODS_NONE,                                            PGM_SET2_PAUSE,             PGM_SET2_SPECIAL_NONE     },
+    { KC_BREAK,        MODS_LCTRL | MODS_RCTRL,                              PGM_SET2_CTRL_BREAK_MAKE,   PGM_SET2_SPECIAL_NONE     },
+    { KC_BREAK,        MODS_NONE,                                            PGM_SET2_BREAK_FAKE_CTRL,   PGM_SET2_SPECIAL_NONE     },
+};
+
+#define SPECIAL_KEY_COUNT (sizeof(_specialKeys) / sizeof(_specialKeys[0]))
+
+/* Entries used by the special keys down, one bit per entry. A release 
+ * sends the break of the entry used by its make, whatever the modifiers
+ * down by then. */
+static uint16_t _latchedEntries;
+
+_Static_assert(SPECIAL_KEY_COUNT <= 16, "_latchedEntries has a bit per special key entry");
 
 /* Cheeky but risky way to statically define a ByteSequence to 
  * use as a temporary workspace. Resist the urge to change
@@ -431,7 +490,7 @@ static uint8_t _convertedBuffer[] =
 ByteSequence* _converted = (ByteSequence*)_convertedBuffer;
 
 
-static bool CheckForPrintScreen(KeyEvent* keyEvent, ByteSequence* converted);
+static bool ConvertSpecialKey(KeyEvent* keyEvent, ByteSequence* sequence);
 static void UpdateSequenceToBreak(ByteSequence* sequence);
 static bool ConvertToSequence(KeyCode keyCode, ByteSequence* sequence);
 
@@ -446,14 +505,14 @@ ByteSequence* Ps2ScanCodeSet2_KeyEventToSequence(KeyEvent* keyEvent)
 
     ByteSequence_Clear(_converted);
 
-    if (!ConvertToSequence(keyCode, _converted))
+    if (ConvertSpecialKey(keyEvent, _converted))
     {
-        return NULL;
+        return _converted;
     }
-   
-    if (!CheckForPrintScreen(keyEvent, _converted))
-    {
 
+    if (!ConvertToSequence(keyCode, _converted))
+    {
+        return NULL;
     }
 
     if(KeyEvent_IsRelease(keyEvent))
@@ -508,27 +567,61 @@ void UpdateSequenceToBreak(ByteSequence* sequence)
     }
 }
 
-bool CheckForPrintScreen(KeyEvent* keyEvent, ByteSequence* converted)
+/* -----------------------------------------------------------------------
+ *  Reads the complete sequence of a key whose codes depend on the 
+ *  modifiers down from the special key table
+ *   - Returns false if the key is not a special key
+ *   - A make latches the entry matching the modifiers down
+ *   - A release uses the latched entry, or the entry matching the 
+ *     modifiers down if the make was not seen
+ *   - The sequence is left empty for a release that sends nothing
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool ConvertSpecialKey(KeyEvent* keyEvent, ByteSequence* sequence)
 {
-    static ModifierStatus modStatus = MODIFIER_STATUS_NONE;
-
     KeyCode keyCode = KeyEvent_Code(keyEvent);
+    bool press = KeyEvent_IsPress(keyEvent);
+    int8_t chosen = -1;
 
-    ModifierStatus_Update(&modStatus, keyEvent);
-
-    if (keyCode != KC_PRINT_SCREEN)
+    for (uint8_t n = 0; n < SPECIAL_KEY_COUNT; n++)
     {
-        return false;
-    }
+        const Set2SpecialKey* entry = &_specialKeys[n];
+        uint16_t entryBit = (uint16_t)1 << n;
 
-    else if (!ModifierStatus_IsDown(&modStatus, MODS_LSHIFT | MODS_RSHIFT))
-    {
-        ProgMem_ReadByteSequence((uint16_t)PGM_SET2_PRTSC_SHIFT, converted);
-        return true;
+        if (pgm_read_byte(&entry->code) != keyCode)
+            continue;
+
+        if (!press && (_latchedEntries & entryBit))
+        {
+            chosen = n;
+            break;
+        }
+
+        /* A make replaces any entry latched for the key */
+        _latchedEntries &= ~entryBit;
+
+        uint8_t modifiers = pgm_read_byte(&entry->modifiers);
+
+        if (chosen < 0 && (modifiers == MODS_NONE || KeyboardState_AnyDown(modifiers)))
+            chosen = n;
     }
 
-   return false;
-}
+    if (chosen < 0)
+        return false;
 
+    const Set2SpecialKey* entry = &_specialKeys[chosen];
+    const uint8_t* mapEntry;
 
+    if (press)
+    {
+        _latchedEntries |= (uint16_t)1 << chosen;
+        mapEntry = (const uint8_t*)pgm_read_word(&entry->make);
+    }
+    else
+    {
+        _latchedEntries &= ~((uint16_t)1 << chosen);
+        mapEntry = (const uint8_t*)pgm_read_word(&entry->brk);
+    }
 
+    ProgMem_ReadByteSequence((uint16_t)mapEntry, sequence);
+    return true;
+}
@@ -0,0 +1,165 @@
+/* =======================================================================
+ * typematic.c
+ *
+ * Purpose:
+ *  Generates typematic key presses for the last key pressed.
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+#include <avr/pgmspace.h>
+
+#include "config.h"
+#include "typematic.h"
+#include "keycode.h"
+#include "system_tick.h"
+
+typedef enum _TypematicState
+{
+    TM_INACTIVE,
+    TM_DELAY,
+    TM_ACTIVE
+} TypematicState;
+
+/* From IBM docs: typematic period = (8 + A) * 2^B * 0.00417 seconds
+ *  where A = bits[2:0]; B = bits[4:3]
+ * 0.00417 is 1/240 of a second, which gives the documented 30.0 to 2.0
+ * characters per second exactly. */
+#define PERIOD_TICKS(A, B) \
+    ((uint16_t)(((8UL + (A)) << (B)) * 1000000UL / (240UL * SYSTEM_TICK_PERIOD_US)))
+
+static const uint16_t _periodTicks[32] PROGMEM = {
+    PERIOD_TICKS(0, 0), /* 30.0 cps */
+    PERIOD_TICKS(1, 0), /* 26.7 cps */
+    PERIOD_TICKS(2, 0), /* 24.0 cps */
+    PERIOD_TICKS(3, 0), /* 21.8 cps */
+    PERIOD_TICKS(4, 0), /* 20.0 cps */
+    PERIOD_TICKS(5, 0), /* 18.5 cps */
+    PERIOD_TICKS(6, 0), /* 17.1 cps */
+    PERIOD_TICKS(7, 0), /* 16.0 cps */
+    PERIOD_TICKS(0, 1), /* 15.0 cps */
+    PERIOD_TICKS(1, 1), /* 13.3 cps */
+    PERIOD_TICKS(2, 1), /* 12.0 cps */
+    PERIOD_TICKS(3, 1), /* 10.9 cps */
+    PERIOD_TICKS(4, 1), /* 10.0 cps */
+    PERIOD_TICKS(5, 1), /*  9.2 cps */
+    PERIOD_TICKS(6, 1), /*  8.6 cps */
+    PERIOD_TICKS(7, 1), /*  8.0 cps */
+    PERIOD_TICKS(0, 2), /*  7.5 cps */
+    PERIOD_TICKS(1, 2), /*  6.7 cps */
+    PERIOD_TICKS(2, 2), /*  6.0 cps */
+    PERIOD_TICKS(3, 2), /*  5.5 cps */
+    PERIOD_TICKS(4, 2), /*  5.0 cps */
+    PERIOD_TICKS(5, 2), /*  4.6 cps */
+    PERIOD_TICKS(6, 2), /*  4.3 cps */
+    PERIOD_TICKS(7, 2), /*  4.0 cps */
+    PERIOD_TICKS(0, 3), /*  3.7 cps */
+    PERIOD_TICKS(1, 3), /*  3.3 cps */
+    PERIOD_TICKS(2, 3), /*  3.0 cps */
+    PERIOD_TICKS(3, 3), /*  2.7 cps */
+    PERIOD_TICKS(4, 3), /*  2.5 cps */
+    PERIOD_TICKS(5, 3), /*  2.3 cps */
+    PERIOD_TICKS(6, 3), /*  2.1 cps */
+    PERIOD_TICKS(7, 3), /*  2.0 cps */
+};
+
+/* From IBM docs: typematic delay = (1 + A) * 250 milliseconds
+ *  where A = bits[6:5] */
+#define DELAY_UNIT_TICKS ((uint16_t)SYSTEM_TICK_MS_TO_TICKS(250))
+
+#if SYSTEM_TICKS_PER_MS * 1000UL > 0xFFFF
+    #error "Typematic delay does not fit in 16 bits of system ticks."
+#endif
+
+static TypematicState _state = TM_INACTIVE;
+static KeyCode _activeKey;
+static SystemTick _deadline;
+
+static uint16_t _period;    /* Ticks */
+static uint16_t _delay;     /* Ticks */
+
+void Typematic_Init(void)
+{
+    _state = TM_INACTIVE;
+    Typematic_SetRate(TYPEMATIC_DEFAULT_RATE);
+}
+
+void Typematic_Reset(void)
+{
+    _state = TM_INACTIVE;
+}
+
+void Typematic_SetRate(uint8_t rate)
+{
+    _period = pgm_read_word(&_periodTicks[rate & 0x1F]);
+    _delay = DELAY_UNIT_TICKS * (1 + ((rate & 0x60) >> 5));
+}
+
+/* -----------------------------------------------------------------------
+ *  Selects the repeating key
+ *   - Modifiers neither repeat nor stop the repeating key, so holding a
+ *     key and then a modifier repeats the modified key
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void Typematic_OnKeyEvent(const KeyEvent* keyEvent, bool repeatable)
+{
+    KeyCode code = KeyEvent_Code(keyEvent);
+
+    if (code >= KC_LCTRL && code <= KC_RGUI)
+        return;
+
+    if (KeyEvent_IsPress(keyEvent))
+    {
+        if (repeatable)
+        {
+            _activeKey = code;
+            _deadline = SystemTick_Deadline(_delay);
+            _state = TM_DELAY;
+        }
+        else
+        {
+            _state = TM_INACTIVE;
+        }
+    }
+    else if (code == _activeKey)
+    {
+        _state = TM_INACTIVE;
+    }
+}
+
+bool Typematic_Update(KeyEvent* repeat)
+{
+    if (_state == TM_INACTIVE || !SystemTick_DeadlinePassed(_deadline))
+        return false;
+
+    /* Advance from the deadline so the period does not drift with the
+     * main loop latency */
+    _deadline += _period;
+    _state = TM_ACTIVE;
+
+    /* Skip repeats missed while the host held the bus rather than
+     * sending them in a burst */
+    if (SystemTick_DeadlinePassed(_deadline))
+        _deadline = SystemTick_Deadline(_period);
+
+    KeyEvent_Init(repeat, KEY_ACTION_PRESS, _activeKey);
+
+    return true;
+}
+
+bool Typematic_IsRepeating(void)
+{
+    return _state == TM_ACTIVE;
+}
+
+uint16_t Typematic_Period(void)
+{
+    return _period;
+}
+
+uint16_t Typematic_Delay(void)
+{
+    return _delay;
+}
@@ -0,0 +1,112 @@
+/* =======================================================================
+ * typematic.h
+ *
+ * Purpose:
+ *  Generates typematic (auto repeat) key presses for the last key
+ *  pressed, independent of the repeats sent by the source keyboard.
+ *
+ * Operational Summary:
+ *  Key events passed to Typematic_OnKeyEvent() select the repeating key.
+ *  Typematic_Update() is called periodically and returns a press event
+ *  for that key once the delay and then each repeat period has elapsed.
+ *  Modifiers never repeat, and pressing one does not interrupt the
+ *  repeating key. Delay and period are set using the IBM typematic
+ *  rate/delay byte, e.g. from the PS/2 Set Typematic Rate command.
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+
+#ifndef TYPEMATIC_H_
+#define TYPEMATIC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "keyevent.h"
+
+/* IBM default: 10.9 characters per second after 500 milliseconds */
+#define TYPEMATIC_DEFAULT_RATE 0x2B
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Initializes the typematic engine with the default rate and delay.
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void Typematic_Init(void);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Stops any repeating key.
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void Typematic_Reset(void);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Sets the repeat period and delay.
+ *
+ * Parameters:
+ *  rate - IBM typematic byte, bits[4:0] select the period from 30 to 2
+ *         characters per second, bits[6:5] the delay from 250 to 1000
+ *         milliseconds.
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void Typematic_SetRate(uint8_t rate);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Updates the repeating key from a key event.
+ *   - A press of a repeatable key other than a modifier starts its delay
+ *   - A press of a key that does not repeat stops the repeating key
+ *   - A release of the repeating key stops it
+ *
+ * Parameters:
+ *  keyEvent   - the key event sent to the host
+ *  repeatable - true if the host allows the key to repeat
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void Typematic_OnKeyEvent(const KeyEvent* keyEvent, bool repeatable);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if a repeat of the repeating key is due.
+ *
+ * Parameters:
+ *  repeat - receives the press event to send
+ *
+ * Returns: bool
+ *   true  - if a repeat is due
+ *   false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Typematic_Update(KeyEvent* repeat);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if the delay has passed and the key is repeating.
+ *
+ * Returns: bool
+ *   true  - if a key is repeating
+ *   false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Typematic_IsRepeating(void);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Gets the current repeat period and delay in system ticks.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+uint16_t Typematic_Period(void);
+uint16_t Typematic_Delay(void);
+
+#endif /* TYPEMATIC_H_ */
@@ -6,6 +6,7 @@ typedef enum _ConsoleMessageIdKeymap
     CON_MSG_KEYMAP_LAYER_CHANGE,
     CON_MSG_KEYMAP_COMBO,
     CON_MSG_KEYMAP_SWAP,
+    CON_MSG_KEYMAP_REMAP_RELEASE,
 
 } ConsoleMessageIdKeymap;
 
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "config.h"
 
@@ -28,6 +29,7 @@
 #include "xt_scancode.h"
 #include "keycode.h"
 #include "modifier_status.h"
+#include "keyboard_state.h"
 
 #include "console.h"
 #include "con_msg_keymap.h"
@@ -58,6 +60,11 @@ uint8_t _eepromSelectedKeymap[SELECTED_KEYMAP_EEPROM_SIZE] EEMEM =
 /* === Preprocessor Definitions ======================================= */
 #define MAX_KEY_COMBOS ((STOCK_KEY_COMBO_SIZE > USER_KEY_COMBO_SIZE)?(STOCK_KEY_COMBO_SIZE):(USER_KEY_COMBO_SIZE))
 
+/* Keys held at once whose mapped KeyCode is recorded for the release */
+#ifndef KEYMAP_HELD_KEYS
+    #define KEYMAP_HELD_KEYS 10
+#endif
+
 /* === Type Definitions ============================================== */
 typedef enum
 {
@@ -66,26 +73,39 @@ typedef enum
 } KeymapSelection;
 #define NUM_KEYMAPS ((uint8_t)(USER + 1))
 
+/* A held key and the KeyCode its press was mapped to */
+typedef struct
+{
+    XtScanCode  scanCode;       /* XT_SC_NONE if the slot is free */
+    KeyCode     code;           /* KC_NONE once released by a remap */
+    bool        releasePending; /* Mapping changed, release not yet sent */
+} HeldKey;
+
 
 /* === Static Global Variable Declarations ============================ */
 static KeymapSelection _selectedKeymap = STOCK;
 static const Keymap* _keymaps[2] = {&stockKeyMap, &userKeyMap};
-static ModifierStatus _mappedModStatus = { .Mods = MODS_NONE };
 static uint8_t _currentKeymapLayer = 0;
 
+/* Set when the keymap or layer changes */
+static bool _mappingChanged = false;
+
+static HeldKey _heldKeys[KEYMAP_HELD_KEYS];
+
 
 /* === Forward Declarations =========================================== */
 bool Keymap_CheckForKeyCombo( KeyEvent* keyEvent);
 bool Keymap_CheckForKeymapSwap ( XtScanCode scanCode, KeyEvent* keyEvent );
 static inline bool Keymap_CheckForLayerChange(KeyEvent* keyEvent);
-KeyCode Keymap_CheckForSupressedKey(KeyEvent* keyEvent);
 static inline KeyCode Keymap_MapScanCodeToKeyCode(const Keymap* keymap, XtScanCode xtScanCode, uint8_t layer);
+static HeldKey* Keymap_FindHeldKey(XtScanCode scanCode);
+static void Keymap_MarkRemappedKeys(void);
 
 /* -----------------------------------------------------------------------
  *  The keymap allows two key combinations to be defined that will be mapped
  *  to a single key stroke. The keys are a modifier + a non-modifier.
- *  This function records the modifier state and for each key stroke,
- *  checks each key combination to determine if the current key satisfies it
+ *  Using the modifier state sent to the host, for each key stroke this
+ *  function checks each key combination to determine if the current key satisfies it
  *  requirements. If so, the KeyEvent is modified with the mapped keycode.
  *  Returns: 
  *    true  - if key combination was completed and a keycode mapped.
@@ -99,7 +119,7 @@ bool Keymap_CheckForKeyCombo( KeyEvent* keyEvent)
     static bool _active[MAX_KEY_COMBOS];
 
     /* If no modifiers are down, no KeyCombination can be triggered */
-    if (ModifierStatus_None(&_mappedModStatus))
+    if (KeyboardState_NoneDown())
         return false;
 
     /* Iterate through all defined KeyCombinations and check to see if the 
@@ -114,7 +134,7 @@ bool Keymap_CheckForKeyCombo( KeyEvent* keyEvent)
             if (KeyEvent_IsPress(keyEvent))
             {
                 /* If the required mods are down, map the KeyCode and mark as active */
-                if(ModifierStatus_IsDown(&_mappedModStatus, combo->RequiredModifiers))
+                if(KeyboardState_AllDown(combo->RequiredModifiers))
                 {
                     CONSOLE_SEND888(CON_SRC_KEYMAP, CON_SEV_TRACE_EVENT, CON_MSG_KEYMAP_COMBO, combo->Original, combo->RequiredModifiers, combo->MappedTo);
                     keyEvent->code = combo->MappedTo;
@@ -150,7 +170,6 @@ bool Keymap_CheckForKeyCombo( KeyEvent* keyEvent)
  *  Every time a scan code is received from the the keyboard it is examined.
  *  If the scan code is the swap key and the left and right shift keys are
  *  in the pressed/down state, the keymap is swapped.
- *  The shift key state is tracked as a state variable across calls.
  *  The press status of the swap key is also tracked as the swap key press
  *  and release events as part of the keymap swap combination should not be 
  *  passed on to the host.
@@ -158,26 +177,11 @@ bool Keymap_CheckForKeyCombo( KeyEvent* keyEvent)
 bool Keymap_CheckForKeymapSwap ( XtScanCode scanCode, KeyEvent* keyEvent )
 {
     static bool _swapKeyDown = false;
-    static ModifierStatus _shiftStatus =  { .Mods = MODS_NONE }; 
     bool isBreakCode = !KeyEvent_IsPress(keyEvent);
 
-    /* If the scan code represents a:
-     *  - left or right shift key, modify shift status and return false.
-     *  - the defined SWAPKEY, continue.
-     *  - any other key, return false. */
-    switch (scanCode)
-    {
-        case XT_SC_RSHIFT: 
-            ModifierStatus_Set(&_shiftStatus, MODS_RSHIFT, !isBreakCode);
-            return false;
-        case XT_SC_LSHIFT:
-            ModifierStatus_Set(&_shiftStatus, MODS_LSHIFT, !isBreakCode);
-            return false;
-        case USER_KEYMAP_SWAP_KEY:
-            break;
-        default:
-            return false;
-    }
+    /* Only the defined SWAPKEY can complete the combination */
+    if (scanCode != USER_KEYMAP_SWAP_KEY)
+        return false;
 
     /* SWAPKEY PRESS */
     if (!isBreakCode ) 
@@ -185,7 +189,7 @@ bool Keymap_CheckForKeymapSwap ( XtScanCode scanCode, KeyEvent* keyEvent )
         /* If both shift keys are down and the SWAPKEY is not already down,
          * this is the first time we have detected the swap combination; 
          *  => Swap keymaps */
-        if (ModifierStatus_IsDown(&_shiftStatus, (MODS_LSHIFT | MODS_RSHIFT)) &&
+        if (KeyboardState_AllDown(MODS_LSHIFT | MODS_RSHIFT) &&
             !_swapKeyDown)
         {
             /* Mark the SWAPKEY as down */
@@ -193,6 +197,7 @@ bool Keymap_CheckForKeymapSwap ( XtScanCode scanCode, KeyEvent* keyEvent )
 
             /* Swap the selected keymap */
             _selectedKeymap = (_selectedKeymap == STOCK) ? USER : STOCK;
+            _mappingChanged = true;
 
             /* Update the KeyCode to indicate the new keymap */
             keyEvent->code = (_selectedKeymap == STOCK) ? KC_S : KC_U;
@@ -242,6 +247,7 @@ static inline bool Keymap_CheckForLayerChange(KeyEvent* keyEvent)
         (keyEvent->code == KC_MOMENTARY_LAYER))
     {
         _currentKeymapLayer = (_currentKeymapLayer + 1) % 2;
+        _mappingChanged = true;
         CONSOLE_SEND8(CON_SRC_KEYMAP, CON_SEV_TRACE_EVENT, CON_MSG_KEYMAP_LAYER_CHANGE, _currentKeymapLayer);
         layerChanged = true;
     }
@@ -255,48 +261,6 @@ static inline bool Keymap_CheckForLayerChange(KeyEvent* keyEvent)
     return layerChanged;
 }
 
-/* -----------------------------------------------------------------------
- *  Checks to see if the KeyEvent requires a modifier that is currently
- *  in the DOWN state to be suppressed. This is a special case for the 
- *  XT keyboard which requires certain key to be suppressed when they
- *  are converted to PS/2 or USB.
- *  Returns:
- *   KeyCode of modifier to be suppressed
- *   KC_NONE if no modifier should be suppressed.
- *  Note: It is also possible for this function to modify the value of 
- *        the KeyEvent passed as an argument.
- * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-KeyCode Keymap_CheckForSupressedKey(KeyEvent* keyEvent)
-{
-    
-    switch(keyEvent->code)
-    {
-        /* On the XT keyboard, L_CTRL + NUM_LOCK is mapped to PAUSE. This 
-         * causes a problem as CTRL + PAUSE is mapped to Break by both
-         * PS/2 and USB. Therefore, L_CTRL has to be suppressed on PRESS. 
-         * On RELEASE, PS/2 does not send any code, so we need to change 
-         * the KeyCode to KC_NONE to suppress the PAUSE itself.*/
-        case KC_PAUSE:
-            if (ModifierStatus_IsDown(&_mappedModStatus, MODS_LCTRL))
-            {
-                if (KeyEvent_IsPress(keyEvent))
-                {
-                    keyEvent->code = KC_PAUSE;
-                    return KC_LCTRL;
-                }
-                else
-                {
-                    keyEvent->code = KC_NONE;
-                }
-            }
-            break;
-        default:
-            break;
-    }
-    
-    return KC_NONE;    
-}
-
 /* -----------------------------------------------------------------------
  *  Initialize the keymap.
  *    - Read the last selected keymap index from EEPROM
@@ -323,22 +287,16 @@ void Keymap_Init(void)
 bool Keymap_MapToKeyEvent (KeyEvent* xtEvent, KeyEvent* mappedEvent)
 {
     KeyEvent mapped;
-    KeyEvent suppressed;
 
     mappedEvent->code = KC_NONE;
 
     XtScanCode baseCode = xtEvent->code;
     mapped.action = xtEvent->action;
 
-    suppressed.code = KC_NONE;
-
     /* Map the XT base scan code to the appropriate KeyCode 
      * using the current layer of the current keymap.*/
     mapped.code = Keymap_MapScanCodeToKeyCode(_keymaps[_selectedKeymap], baseCode, _currentKeymapLayer);
 
-    /* Update the modifier status */
-    ModifierStatus_Update(&_mappedModStatus, &mapped);
-
     /* Check to see if the current key completes the keymap swap combination */
     if (!Keymap_CheckForKeymapSwap(baseCode, &mapped))
     {
@@ -347,37 +305,109 @@ bool Keymap_MapToKeyEvent (KeyEvent* xtEvent, KeyEvent* mappedEvent)
 
         /* Check to see if the current keycode is a layer change. */
         Keymap_CheckForLayerChange(&mapped);
+    }
 
-        if (mapped.code == KC_NONE)
-            return false;
+    /* Held keys are checked before the current key is recorded, it 
+     * already uses the new mapping */
+    if (_mappingChanged)
+        Keymap_MarkRemappedKeys();
 
-        /* Check to see if the current keycode requires 
-         * other keys to be suppressed */
-        suppressed.code = Keymap_CheckForSupressedKey(&mapped);
+    HeldKey* held = Keymap_FindHeldKey(baseCode);
 
+    if (KeyEvent_IsPress(&mapped))
+    {
         if (mapped.code == KC_NONE)
             return false;
-    }
 
-    /* If a key must be suppressed, add a release before and press 
-     * following the current KeyEvent */
+        /* Record the KeyCode sent for the release, unless all slots are 
+         * in use. The release is then mapped like the press. */
+        if (held == NULL)
+            held = Keymap_FindHeldKey(XT_SC_NONE);
 
-    if (suppressed.code != KC_NONE)
+        if (held != NULL)
+        {
+            held->scanCode = baseCode;
+            held->code = mapped.code;
+            held->releasePending = false;
+        }
+    }
+    else if (held != NULL)
     {
-        suppressed.action = KEY_ACTION_RELEASE;
-        KeyEvent_Copy(&suppressed, mappedEvent);
+        /* Release the KeyCode the key was pressed with, nothing if it
+         * was already released by a remap */
+        mapped.code = held->code;
+        held->scanCode = XT_SC_NONE;
     }
 
+    if (mapped.code == KC_NONE)
+        return false;
+
+    /* Modifiers that conflict with the mapped key, e.g. ctrl with a Pause
+     * mapped from ctrl + NumLock, are handled by the scan code converter */
     KeyEvent_Copy(&mapped, mappedEvent);
 
-    if (suppressed.code != KC_NONE)
+    return true;
+}
+
+/* -----------------------------------------------------------------------
+ *  Returns the release of a held key whose mapping was changed by a 
+ *  keymap or layer change, one key per call. The key's own release is 
+ *  discarded later.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Keymap_GetRemappedRelease(KeyEvent* release)
+{
+    for (uint8_t n = 0; n < KEYMAP_HELD_KEYS; n++)
+    {
+        HeldKey* held = &_heldKeys[n];
+
+        if (held->scanCode == XT_SC_NONE || !held->releasePending)
+            continue;
+
+        CONSOLE_SEND88(CON_SRC_KEYMAP, CON_SEV_TRACE_EVENT, CON_MSG_KEYMAP_REMAP_RELEASE, held->scanCode, held->code);
+
+        KeyEvent_Init(release, KEY_ACTION_RELEASE, held->code);
+        held->code = KC_NONE;
+        held->releasePending = false;
+        return true;
+    }
+
+    return false;
+}
+
+/* -----------------------------------------------------------------------
+ *  Returns the held key slot of the scan code, XT_SC_NONE finds a free 
+ *  slot. Returns NULL if there is none.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static HeldKey* Keymap_FindHeldKey(XtScanCode scanCode)
+{
+    for (uint8_t n = 0; n < KEYMAP_HELD_KEYS; n++)
     {
-        suppressed.action = KEY_ACTION_PRESS;
-        KeyEvent_Copy(&suppressed, mappedEvent);
+        if (_heldKeys[n].scanCode == scanCode)
+            return &_heldKeys[n];
     }
 
+    return NULL;
+}
 
-    return true;
+/* -----------------------------------------------------------------------
+ *  Marks the held keys that the current keymap and layer map to a 
+ *  different KeyCode for release. Keys whose mapping is unchanged, e.g.
+ *  modifiers held across a layer change, stay down.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void Keymap_MarkRemappedKeys(void)
+{
+    _mappingChanged = false;
+
+    for (uint8_t n = 0; n < KEYMAP_HELD_KEYS; n++)
+    {
+        HeldKey* held = &_heldKeys[n];
+
+        if (held->scanCode == XT_SC_NONE || held->code == KC_NONE)
+            continue;
+
+        if (Keymap_MapScanCodeToKeyCode(_keymaps[_selectedKeymap], held->scanCode, _currentKeymapLayer) != held->code)
+            held->releasePending = true;
+    }
 }
 
 /* -----------------------------------------------------------------------
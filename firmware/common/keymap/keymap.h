@@ -42,4 +42,20 @@ void Keymap_Init(void);
  *------------------------------------------------------------------------*/
  bool Keymap_MapToKeyEvent(KeyEvent* xtEvent, KeyEvent* mappedEvent);
 
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Gets the release of a held key that a keymap or layer change has
+ *  mapped to a different KeyCode. The caller sends the releases before
+ *  the key that caused the change. Held keys are otherwise released 
+ *  with the KeyCode they were pressed with.
+ *
+ * Parameters:
+ *  release - the release KeyEvent.
+ *
+ * Returns: bool
+ *   true  - if a release was returned
+ *   false - if no remapped key is waiting to be released
+ *------------------------------------------------------------------------*/
+bool Keymap_GetRemappedRelease(KeyEvent* release);
+
 #endif /* KEYMAP_H_ */
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include <avr/pgmspace.h>
 
 #include "keymap_common.h"
+#include "xt_scancode.h"
 
 
 static const KeyCode stockScanCodeMap[][2] PROGMEM = {
@@ -106,8 +107,39 @@ static const KeyCode stockScanCodeMap[][2] PROGMEM = {
     /* XT_KP_3        Keypad 3   */ {KC_KP_3,              KC_KP_3,           },
     /* XT_KP_0        Keypad 0   */ {KC_KP_0,              KC_KP_0,           },
     /* XT_KP_DOT      Keypad .   */ {KC_KP_DOT,            KC_KP_DOT,         }, 
+
+    /* Enhanced keyboard keys */
+    /* XT_SYSREQ      SysRq      */ {KC_SYSREQ,            KC_SYSREQ,         },
+    /* 0x55                      */ {KC_NONE,              KC_NONE,           },
+    /* XT_INTL_BSLASH Intl \     */ {KC_NONUS_BSLASH,      KC_NONUS_BSLASH,   },
+    /* XT_F11         F11        */ {KC_F11,               KC_F11,            },
+    /* XT_F12         F12        */ {KC_F12,               KC_F12,            },
+    /* XT_KP_ENTER    Keypad Ent */ {KC_KP_ENTER,          KC_KP_ENTER,       },
+    /* XT_RCONTROL    Ctrl R     */ {KC_RCTRL,             KC_RCTRL,          },
+    /* XT_KP_SLASH    Keypad /   */ {KC_KP_SLASH,          KC_KP_SLASH,       },
+    /* XT_PRTSC       PrtSc      */ {KC_PRINT_SCREEN,      KC_PRINT_SCREEN,   },
+    /* XT_RALT        Alt R      */ {KC_RALT,              KC_RALT,           },
+    /* XT_BREAK       Break      */ {KC_BREAK,             KC_BREAK,          },
+    /* XT_HOME        Home       */ {KC_HOME,              KC_HOME,           },
+    /* XT_UP          Up         */ {KC_UP,                KC_UP,             },
+    /* XT_PAGE_UP     Page Up    */ {KC_PAGE_UP,           KC_PAGE_UP,        },
+    /* XT_LEFT        Left       */ {KC_LEFT,              KC_LEFT,           },
+    /* XT_RIGHT       Right      */ {KC_RIGHT,             KC_RIGHT,          },
+    /* XT_END         End        */ {KC_END,               KC_END,            },
+    /* XT_DOWN        Down       */ {KC_DOWN,              KC_DOWN,           },
+    /* XT_PAGE_DOWN   Page Down  */ {KC_PAGE_DOWN,         KC_PAGE_DOWN,      },
+    /* XT_INSERT      Insert     */ {KC_INSERT,            KC_INSERT,         },
+    /* XT_DELETE      Delete     */ {KC_DELETE,            KC_DELETE,         },
+    /* XT_LGUI        GUI L      */ {KC_LGUI,              KC_LGUI,           },
+    /* XT_RGUI        GUI R      */ {KC_RGUI,              KC_RGUI,           },
+    /* XT_APPLICATION Menu       */ {KC_APPLICATION,       KC_APPLICATION,    },
+    /* XT_PAUSE       Pause      */ {KC_PAUSE,             KC_PAUSE,          },
 }; 
 
+/* One row per XT scan code, indexed by the code less one */
+_Static_assert(sizeof(stockScanCodeMap) / sizeof(stockScanCodeMap[0]) == XT_SC_MAX_CODE,
+               "stockScanCodeMap needs a row for every XT scan code");
+
 /* Note, this is SRAM */
 static const KeyCombination stockKeyCombinations[] = {
     {MODS_LSHIFT, KC_KP_ASTERISK, KC_PRINT_SCREEN},
@@ -21,6 +21,7 @@
 #include "keymap.h"
 #include "led_status.h"
 #include "keyevent.h"
+#include "system_tick.h"
 
 
 #include <avr/io.h>
@@ -58,14 +59,20 @@ int main(void)
 
     Device_Init(&StatusLedUpdateReceivedHandler);
 
-    EnableGlobalInterrupts();
+    /* Timestamp console messages with the system tick */
+    Console_SetTimestampSource(&SystemTick_Now, SYSTEM_TICK_PERIOD_US);
 
-    Device_Start();
+    EnableGlobalInterrupts();
 
+    /* Start the host first so the XT keyboard reset runs while the 
+     * device performs POR/BAT */
     Host_Start();
 
+    Device_Start();
+
     KeyEvent hostEvent;
     KeyEvent mappedEvent;
+    KeyEvent releaseEvent;
 
     Watchdog_Enable();
 
@@ -75,16 +82,25 @@ int main(void)
 
         Host_Update();
 
-        if (Host_GetKeyEvent(&hostEvent))
+        /* Key events are held by the host until the device has completed
+         * initialization */
+        if (Device_IsReady() && Host_GetKeyEvent(&hostEvent))
         {
-            if(Keymap_MapToKeyEvent(&hostEvent, &mappedEvent))
+            bool mapped = Keymap_MapToKeyEvent(&hostEvent, &mappedEvent);
+
+            /* Release the held keys remapped by a keymap or layer change 
+             * before sending the key that caused it */
+            while (Keymap_GetRemappedRelease(&releaseEvent))
+                Device_SendKeyEvent(&releaseEvent);
+
+            if (mapped)
             {
                 if (KeyEvent_IsPress(&mappedEvent))
                     Board_KeyPressed();
                 else 
                     Board_KeyReleased();
 
-                CONSOLE_SEND8(CON_SRC_XT2PS2, CON_SEV_TRACE_INFO, CON_MSG_XT2PS2_KEYMAPPED, KeyEvent_Code(&mappedEvent));
+                CONSOLE_SEND88(CON_SRC_XT2PS2, CON_SEV_TRACE_INFO, CON_MSG_XT2PS2_KEYMAPPED, KeyEvent_Code(&hostEvent), KeyEvent_Code(&mappedEvent));
 
                 Device_SendKeyEvent(&mappedEvent);
                 
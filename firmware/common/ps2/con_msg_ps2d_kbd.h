@@ -17,7 +17,17 @@ typedef enum _ConsoleMessageIdPs2dKbd
     CON_MSG_PS2D_KBD_POR_END, 
     CON_MSG_PS2D_KBD_BAT_START,     
     CON_MSG_PS2D_KBD_BAT_END, 
+    CON_MSG_PS2D_KBD_HOST_READY,
+    CON_MSG_PS2D_KBD_BOOT_READY,
+    CON_MSG_PS2D_KBD_BOOT_FIRST_KEY,
 
 } ConsoleMessageIdPs2dKbd;
 
+/* Reset phase ended early, data of CON_MSG_PS2D_KBD_HOST_READY */
+typedef enum _ConsolePs2dKbdResetPhase
+{
+    CON_PS2D_KBD_PHASE_POR,
+    CON_PS2D_KBD_PHASE_BAT,
+} ConsolePs2dKbdResetPhase;
+
 #endif /* CON_MSG_PS2D_KBD_H */
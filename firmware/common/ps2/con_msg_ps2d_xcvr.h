@@ -10,6 +10,7 @@ typedef enum _ConsoleMessageIdPs2dXcvr
     CON_MSG_PS2D_XCVR_XMIT_BUSY,
     CON_MSG_PS2D_XCVR_REXMIT,
     CON_MSG_PS2D_XCVR_CLK_PERIOD,
+    CON_MSG_PS2D_XCVR_TICK_DELAY,
 } ConsoleMessageIdPs2dXcvr;
 
 #endif /* CON_MSG_PS2D_XCVR_H */
\ No newline at end of file
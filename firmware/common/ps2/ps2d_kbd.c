@@ -29,8 +29,10 @@
 #include "circular_buffer_util.h"
 
 #include "ps2_sc_conv.h"
+#include "typematic.h"
 
 #include "ps2d_xcvr.h"
+#include "system_tick.h"
 #include "ps2d_kbd.h"
 #include "console.h"
 #include "con_msg_ps2d_kbd.h"
@@ -48,62 +50,50 @@ typedef enum
 } KbdState;
 
 
-#ifdef USE_TYPEMATIC
-
-typedef enum _TypematicState
-{
-    TM_INACTIVE,
-    TM_DELAY,
-    TM_ACTIVE
-} TypematicState;
-
-#endif
-
 
 /* === Constant Defintions ============================================ */
 #define PS2D_KBD_MAX_ID_LENGTH 2
 
-#define PS2D_KBD_MIN_POR_DURATION 150UL /* 150 - 2000 milliseconds - from IBM docs */
+#define PS2D_KBD_STD_POR_DURATION 150UL /* 150 - 2000 milliseconds - from IBM docs */
 #define PS2D_KBD_MAX_POR_DURATION 2000UL 
-#define PS2D_KBD_MIN_BAT_DURATION 300UL /* 300 - 500 milliseconds - from IBM docs */
+#define PS2D_KBD_STD_BAT_DURATION 300UL /* 300 - 500 milliseconds - from IBM docs */
 #define PS2D_KBD_MAX_BAT_DURATION 500UL 
 
+/* Fast boot allows the POR and BAT to be shortened below the IBM minimums.
+ * The host is not aware of the POR and only waits for the BAT result. */
+#if PS2D_KBD_FAST_BOOT
+    #define PS2D_KBD_MIN_POR_DURATION 0UL
+    #define PS2D_KBD_MIN_BAT_DURATION 0UL
+#else
+    #define PS2D_KBD_MIN_POR_DURATION PS2D_KBD_STD_POR_DURATION
+    #define PS2D_KBD_MIN_BAT_DURATION PS2D_KBD_STD_BAT_DURATION
+#endif
+
 
 #ifdef PS2D_KBD_POR_DURATION
     #if ((PS2D_KBD_POR_DURATION < PS2D_KBD_MIN_POR_DURATION ) || (PS2D_KBD_POR_DURATION > PS2D_KBD_MAX_POR_DURATION))
         #error "PS2D_KBD_POR_DURATION has invalid value."
     #endif
 #else
-    #define PS2D_KBD_POR_DURATION PS2D_KBD_MIN_POR_DURATION
+    #define PS2D_KBD_POR_DURATION PS2D_KBD_STD_POR_DURATION
 #endif
 
-#define POR_CLOCK_COUNT (uint16_t)PS2D_XCVR_INTERVAL_MS_TO_CLK_COUNT(PS2D_KBD_POR_DURATION)
+#define POR_TICKS SYSTEM_TICK_MS_TO_TICKS(PS2D_KBD_POR_DURATION)
 
 #ifdef PS2D_KBD_BAT_DURATION
     #if ((PS2D_KBD_BAT_DURATION < PS2D_KBD_MIN_BAT_DURATION ) || (PS2D_KBD_BAT_DURATION > PS2D_KBD_MAX_BAT_DURATION))
         #error "PS2D_KBD_BAT_DURATION has invalid value."
     #endif
 #else
-    #define PS2D_KBD_BAT_DURATION PS2D_KBD_MIN_BAT_DURATION
+    #define PS2D_KBD_BAT_DURATION PS2D_KBD_STD_BAT_DURATION
 #endif
 
-#define BAT_CLOCK_COUNT (uint16_t)PS2D_XCVR_INTERVAL_MS_TO_CLK_COUNT(PS2D_KBD_BAT_DURATION)
-
-
-#define PS2D_KBD_DEFAULT_SCAN_CODE_SET PS2_SCAN_CODE_SET2
+#define BAT_TICKS SYSTEM_TICK_MS_TO_TICKS(PS2D_KBD_BAT_DURATION)
 
-/* From IBM docs: typematic interval = (8 + A) * 2^B * 0.00417 
- *  where A = bits[2:0]; B = bits[4:3] */
-#define PS2D_KBD_TYPEMATIC_INTERVAL(bits) \
-    ( (( 8 + (bits & 0x7)) * (1 << ((bits & 0x3) >> 3)) * 417UL / 100000UL ) 
+#define HOST_IDLE_CLOCK_COUNT (uint16_t)PS2D_XCVR_INTERVAL_MS_TO_CLK_COUNT(PS2D_KBD_FAST_BOOT_HOST_IDLE)
 
-/* From IBM docs: typematic delay = (1 + A) * 250
- *  where A = bits[6:5] */
-#define PS2D_KBD_TYPEMATIC_DELAY(bits) \
-    ( (1 + ((bits  & b01100000) >> 5)) * 250UL )
 
-/* Default rate values 92ms and 500ms b01001011 */
-#define PS2D_KBD_DEFAULT_TYPEMATIC_RATE 0x4B
+#define PS2D_KBD_DEFAULT_SCAN_CODE_SET PS2_SCAN_CODE_SET2
 
 /* Delay between consecutive bytes sent*/
 #define INTER_BYTE_DELAY_CLOCKS (uint16_t)PS2D_XCVR_INTERVAL_US_TO_CLK_COUNT(PS2D_KBD_INTER_BYTE_DELAY)
@@ -119,22 +109,15 @@ static uint8_t _ps2Id[PS2D_KBD_MAX_ID_LENGTH] = PS2D_KBD_DEVICE_ID;
 static uint8_t _ps2IdLength = PS2D_KBD_MAX_ID_LENGTH;
 
 static KbdState _state = PS2D_KBD_IDLE;
-static uint16_t _clockCountStart;
+static SystemTick _resetDeadline;
 
 static Ps2KeyCondition _keyConditions[KEY_CODE_COUNT];
 
-#ifdef USE_TYPEMATIC
-
-static TypematicState _typematicState = TM_INACTIVE;
-static KeyCode _typematicActiveKey;
-static uint16_t _typematicCount;
-
-static uint16_t _typematicDelay;
-static uint16_t _typematicInterval;
-
-static ByteSequence* _typematicSequence;
-static uint8_t _typematicSequenceStorage[PS2_MAX_SEQUENCE_LENGTH + 1];
-
+#ifdef USE_CONSOLE
+/* Boot time metric: milliseconds elapsed since Ps2dKbd_Start() until the
+ * first key press is sent to the host. */
+static bool _bootTiming = false;
+static SystemTick _bootStart;
 #endif
 
 
@@ -149,6 +132,9 @@ static Ps2ScanCodeSet _scanCodeSet = PS2_SCAN_CODE_SET2;
 /* Funcion callack invoked when BAT is exectued. */
 static Ps2dKbd_BatHandler _batHandler = &defaultBatHandler;
 static bool _batSuccess;
+/* Set while the power-on POR/BAT is in progress, a host-initiated reset
+ * is never shortened by fast boot */
+static bool _powerOnReset = false;
 /* Function callback invoked when a Set LED command is received from the host */
 static Ps2dKbd_LedStatusUpdate _ledStatusUpdateHandler = &defaultLedStatusUpdateHandler;
 /* Function callback invoked when a Reset command is received from the host */
@@ -167,12 +153,15 @@ static void ProcessReceivedData(uint8_t data);
 static void SendPs2Id(void);
 static void SendResponse(uint8_t response);
 static Ps2KeyCondition KeyCondition(KeyCode keycode);
+static bool HostReady(void);
+static void BootTimeStart(void);
+static uint16_t BootTime(void);
 
 
 static void TypematicInit(void);
 static void TypematicReset(void);
 static void TypematicCheck(void);
-static void TypematicOnKeyEvent(KeyEvent* keyEvent, ByteSequence* sequence);
+static void TypematicOnKeyEvent(KeyEvent* keyEvent);
 static void TypematicUpdateRate(uint8_t bits);
 
 /* TODO for Scan code set 3 support
@@ -201,13 +190,14 @@ void Ps2Kbd_SetScanCodeSet(Ps2ScanCodeSet scanCodeSet)
         case PS2_SCAN_CODE_SET1:
             break;
 
-        /* Scan code set 2: All keys make/break/typematic except PAUSE which is make only */
+        /* Scan code set 2: All keys make/break/typematic except PAUSE and BREAK which are make only */
         case PS2_SCAN_CODE_SET2:
             for (int i = 0; i < sizeof(_keyConditions); i++)
             {
                 _keyConditions[i] = PS2_KEY_COND_ALL;
             }
             _keyConditions[KC_PAUSE] = PS2_KEY_COND_MAKE;
+            _keyConditions[KC_BREAK] = PS2_KEY_COND_MAKE;
    
             break;
 
@@ -237,7 +227,7 @@ void Ps2dKbd_Init(Ps2dKbd_BatHandler batHandler,
 
     CircularBuffer_Init(&_sendBuffer, _sendBufferStorage, PS2D_SEND_STORAGE_SIZE);
 
-    CONSOLE_SEND8(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_CLKS_MS, PS2D_XCVR_CLOCKS_PER_MS);
+    CONSOLE_SEND8(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_CLKS_MS, SYSTEM_TICKS_PER_MS);
     
     TypematicInit();
 
@@ -275,8 +265,32 @@ void Ps2dKbd_SendSequence(const ByteSequence* sequence)
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Ps2dKbd_Start(void)
 {
+    BootTimeStart();
     PorInitiate();
 }
+/* ------------------------------------------------------------------------
+ *  Determine if POR or BAT is in progress
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Ps2dKbd_IsResetting(void)
+{
+    switch (_state)
+    {
+        case PS2D_KBD_POR_WAIT:
+        case PS2D_KBD_RESET_WAIT_ACK:
+        case PS2D_KBD_BAT_WAIT:
+        case PS2D_KBD_BAT_XMIT:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool Ps2dKbd_IsEnabled(void)
+{
+    return _enabled;
+}
+
 /* ------------------------------------------------------------------------
  *  Periodic update task for the PS/2 Keyboard subsystem
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
@@ -284,6 +298,8 @@ void Ps2dKbd_Task(void)
 {
     uint8_t data;
 
+    Ps2dXcvr_ReportTickDelay();
+
     switch(_state)
     {
         case PS2D_KBD_IDLE:
@@ -355,12 +371,8 @@ void Ps2dKbd_OnKeyEvent(KeyEvent* keyEvent)
     if (!_enabled)
         return;
 
-    CONSOLE_SEND88(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_KEYEVENT, KeyEvent_Code(keyEvent), KeyEvent_Action(keyEvent));
-
     ByteSequence* sendSequence = Ps2ScanCodeConvert(keyEvent, _scanCodeSet);
 
-    TypematicOnKeyEvent(keyEvent, sendSequence);
-
     KeyCode keyCode = KeyEvent_Code(keyEvent);
 
     if (KeyEvent_IsPress(keyEvent))
@@ -368,18 +380,33 @@ void Ps2dKbd_OnKeyEvent(KeyEvent* keyEvent)
     else 
         active = ((KeyCondition(keyCode) & PS2_KEY_COND_BREAK) != 0);
 
-    if (active)
+    if (!active || (sendSequence != NULL && ByteSequence_Length(sendSequence) == 0))
+        sendSequence = NULL;
+
+    /* The length and first byte of the sequence sent let the host match
+     * the event to the bytes on the wire */
+    CONSOLE_SEND8888(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_KEYEVENT, keyCode, KeyEvent_Action(keyEvent),
+                     sendSequence ? ByteSequence_Length(sendSequence) : 0,
+                     sendSequence ? ByteSequence_DataAt(sendSequence, 0) : 0);
+
+    TypematicOnKeyEvent(keyEvent);
+
+    if (sendSequence != NULL)
         Ps2dKbd_SendSequence(sendSequence);
 
+#ifdef USE_CONSOLE
+    if (_bootTiming && KeyEvent_IsPress(keyEvent))
+    {
+        _bootTiming = false;
+        CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_KBD_BOOT_FIRST_KEY, BootTime());
+    }
+#endif
 }
 
 void BatCheckComplete(void)
 {
-    uint16_t currentClockCount = Ps2dXcvr_GetClockCount();
-    uint16_t countSinceStart = (currentClockCount - _clockCountStart);
-
-    /* Waiting for ACK indication from server to complete*/
-    if ( countSinceStart < BAT_CLOCK_COUNT ) {
+    /* Waiting for BAT to complete */
+    if (!SystemTick_DeadlinePassed(_resetDeadline) && !HostReady()) {
         return;
     }
 
@@ -401,6 +428,7 @@ void BatXmit(void)
     /* Wait for host to release buss */
     if (Ps2dXcvr_BusIdle()) {
         _enabled = _batSuccess;
+        _powerOnReset = false;
 
         if (_batSuccess) {
             batResponse = PS2_RESP_SELF_TEST_OK;
@@ -410,17 +438,19 @@ void BatXmit(void)
 
         _state = PS2D_KBD_IDLE;
         CircularBuffer_Insert(&_sendBuffer, batResponse);
+
+#ifdef USE_CONSOLE
+        if (_bootTiming)
+            CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_KBD_BOOT_READY, BootTime());
+#endif
     }
 }
 
 
 void PorCheckComplete(void)
 {
-    uint16_t currentClockCount = Ps2dXcvr_GetClockCount();
-    uint16_t countSinceStart = (currentClockCount - _clockCountStart);    
-
-    /* Waiting for ACK indication from server to complete*/
-    if (countSinceStart < POR_CLOCK_COUNT)
+    /* Waiting for POR to complete */
+    if (!SystemTick_DeadlinePassed(_resetDeadline) && !HostReady())
     {
         return;
     }
@@ -434,9 +464,9 @@ void BatInitiate(void)
 {
     _state = PS2D_KBD_BAT_WAIT;
 
-    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_KBD_BAT_START, BAT_CLOCK_COUNT);
+    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_KBD_BAT_START, PS2D_KBD_BAT_DURATION);
 
-    _clockCountStart = Ps2dXcvr_GetClockCount();
+    _resetDeadline = SystemTick_Deadline(BAT_TICKS);
 
     _ledStatusUpdateHandler(PS2_LED_ALL_ON);
 
@@ -453,10 +483,11 @@ void BatInitiate(void)
 
 void PorInitiate(void)
 {
-    _clockCountStart = Ps2dXcvr_GetClockCount();    
+    _resetDeadline = SystemTick_Deadline(POR_TICKS);
     _state = PS2D_KBD_POR_WAIT;
+    _powerOnReset = true;
 
-    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_KBD_POR_START, POR_CLOCK_COUNT);
+    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_KBD_POR_START, PS2D_KBD_POR_DURATION);
 
 
     return;
@@ -465,6 +496,7 @@ void PorInitiate(void)
 void ResetInitiate(void)
 {
     _enabled = false;
+    _powerOnReset = false;
 
     /* Try to send RESET ACK, if fails, go to RESET_WAIT_ACK
      * else start BAT */
@@ -604,127 +636,109 @@ static Ps2KeyCondition KeyCondition(KeyCode keyCode)
     return _keyConditions[keyCode];
 }
 
+/* ------------------------------------------------------------------------
+ *  Determines if a running host has been detected during POR/BAT.
+ *   - Only used when fast boot is enabled, during the power-on POR/BAT
+ *   - The host is considered ready when the bus has been idle, i.e. not
+ *     inhibited by the host, for PS2D_KBD_FAST_BOOT_HOST_IDLE.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static bool HostReady(void)
+{
+    if (!PS2D_KBD_FAST_BOOT || !_powerOnReset)
+        return false;
+
+    if (Ps2dXcvr_GetIdleCount() < HOST_IDLE_CLOCK_COUNT)
+        return false;
+
+    CONSOLE_SEND8(CON_SRC_PS2D_KBD, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_KBD_HOST_READY, 
+        (_state == PS2D_KBD_POR_WAIT) ? CON_PS2D_KBD_PHASE_POR : CON_PS2D_KBD_PHASE_BAT);
+
+    return true;
+}
+
+
+/* Boot time metric support functions 
+ * -------------------------------------------------------------------------------- */
+#ifdef USE_CONSOLE
+
+void BootTimeStart(void)
+{
+    _bootTiming = true;
+    _bootStart = SystemTick_Now();
+}
+
+/* Milliseconds elapsed since BootTimeStart(), saturates at UINT16_MAX */
+uint16_t BootTime(void)
+{
+    SystemTick ms = SystemTick_Elapsed(_bootStart) / SYSTEM_TICKS_PER_MS;
+
+    return ms < UINT16_MAX ? (uint16_t)ms : UINT16_MAX;
+}
+
+#else
+
+void BootTimeStart(void){}
+uint16_t BootTime(void){ return 0; }
+
+#endif
+
 
 /* Typematic key support functions 
+ *  Repeats are generated by the typematic engine for the last key 
+ *  pressed, at the rate requested by the host.
  * -------------------------------------------------------------------------------- */
 #ifdef USE_TYPEMATIC        
 
 void TypematicInit(void)
 {
-    _typematicState = TM_INACTIVE;
-    TypematicUpdateRate(PS2D_KBD_DEFAULT_TYPEMATIC_RATE);
-    
-    _typematicSequence = ByteSequence_Create(_typematicSequenceStorage, sizeof(_typematicSequenceStorage));
+    Typematic_Init();
 }
 
 void TypematicReset(void)
 {
-    _typematicState = TM_INACTIVE;
+    Typematic_Reset();
 }
 
 void TypematicCheck(void)
 {
-    bool sendKeyPress = false;
-
-    switch (_typematicState)
-    {
-        case TM_INACTIVE:
-            break;
-
-        case TM_DELAY: 
-            {
-                uint16_t currentClockCount = Ps2dXcvr_GetClockCount();
-                uint16_t interval = currentClockCount - _typematicCount;
-                if (interval > _typematicDelay)
-                {
-                    _typematicState = TM_ACTIVE;
-                    _typematicCount = currentClockCount;
-                    sendKeyPress = true;
-                    CONSOLE_SEND8(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_ACTIVE, _typematicActiveKey);                    
-                }
-            }
-            break;
+    KeyEvent repeat;
+    bool wasRepeating = Typematic_IsRepeating();
 
-        case TM_ACTIVE:
-            {
-                uint16_t currentClockCount = Ps2dXcvr_GetClockCount();
-                uint16_t interval = currentClockCount - _typematicCount;
-                if (interval > _typematicInterval)
-                {
-                    _typematicCount = currentClockCount;
-                    sendKeyPress = true;                
-                } 
-            }       
-            break;
-    }
+    if (!Typematic_Update(&repeat))
+        return;
 
-    if (sendKeyPress)
-    {
-        Ps2dKbd_SendSequence(_typematicSequence);        
-    }
+    if (!wasRepeating)
+        CONSOLE_SEND8(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_ACTIVE, KeyEvent_Code(&repeat));
 
-    return;
+    ByteSequence* sequence = Ps2ScanCodeConvert(&repeat, _scanCodeSet);
+    if (sequence != NULL)
+        Ps2dKbd_SendSequence(sequence);
 }
 
-void TypematicOnKeyEvent(KeyEvent* keyEvent, ByteSequence* sequence)
+void TypematicOnKeyEvent(KeyEvent* keyEvent)
 {
-    KeyCode code = KeyEvent_Code(keyEvent);
+    bool wasRepeating = Typematic_IsRepeating();
 
-    if (KeyEvent_IsPress(keyEvent))
-    {
-        if (KeyCondition(code) & PS2_KEY_COND_TYPEMATIC)
-        {
-            _typematicActiveKey = code;
-            ByteSequence_Duplicate(_typematicSequence, sequence);
-            _typematicState = TM_DELAY;
-            _typematicCount = Ps2dXcvr_GetClockCount();
-        }
-    }
-    else if (code == _typematicActiveKey)
-    {
-#ifdef USE_CONSOLE
-        if(_typematicState == TM_ACTIVE)
-        {
-            CONSOLE_SEND0(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_INACTIVE);
-        }
-#endif
-        _typematicState = TM_INACTIVE;
-    }
-}
+    Typematic_OnKeyEvent(keyEvent, (KeyCondition(KeyEvent_Code(keyEvent)) & PS2_KEY_COND_TYPEMATIC) != 0);
 
+    if (wasRepeating && !Typematic_IsRepeating())
+        CONSOLE_SEND0(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_INACTIVE);
+}
 
 void TypematicUpdateRate(uint8_t bits)
 {
-    /* From IBM docs: typematic interval = (8 + A) * 2^B * 0.00417 
-     *  where A = bits[2:0]; B = bits[4:3] 
-     * Note: approximate 4.17ms with 4 using a 2 bit left shift at runtime 
-     *       This equates to 4.25% error which is acceptable */
-//    _typematicInterval =  (uint16_t) (( 8 + (bits & 0x7)) * (1 << ((bits & 0x24) >> 3)) * 17UL / 4096UL ) ;
-    uint16_t A = bits & 0x07;
-    uint16_t B = (bits & 0x18) >> 3;
-
-    _typematicInterval =  (uint16_t) ((8 + A) * (1 << B) << 2 ) * PS2D_XCVR_CLOCKS_PER_MS;
-
-    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_RATE, _typematicInterval);
-
-    /* From IBM docs: typematic delay = (1 + A) * 250
-     *  where A = bits[6:5] 
-     * Note: approximate 250 with 256 with an 8 bit left shift at runtime 
-     *       This results in a 2.4% error which is acceptable */
-    A = (bits & 0x60) >> 5;
-    _typematicDelay = (uint16_t)( (1 + A) << 8 ) * PS2D_XCVR_CLOCKS_PER_MS;
-
-    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_DELAY, _typematicDelay);
-}
+    Typematic_SetRate(bits);
 
+    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_RATE, Typematic_Period());
+    CONSOLE_SEND16(CON_SRC_PS2D_KBD, CON_SEV_TRACE_INFO, CON_MSG_PS2D_KBD_TM_DELAY, Typematic_Delay());
+}
 
 #else
 
 void TypematicInit(void){}
 void TypematicReset(void){}
 void TypematicCheck(void){}
-void TypematicOnKeyEvent(KeyEvent* keyEvent, ByteSequence* sequence){ }
+void TypematicOnKeyEvent(KeyEvent* keyEvent){ }
 void TypematicUpdateRate( uint8_t bits){}
 
 #endif
-
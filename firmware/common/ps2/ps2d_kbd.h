@@ -85,6 +85,35 @@ void Ps2Kbd_SetScanCodeSet(Ps2ScanCodeSet set);
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Ps2dKbd_Start(void);
 
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if the keyboard is performing a power-on-reset or BAT.
+ *  Key events sent while resetting are discarded, callers should hold 
+ *  them until the reset has completed.
+ *
+ * Parameters:
+ *  n/a
+ * 
+ * Returns: bool
+ *  true  - if POR or BAT is in progress
+ *  false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Ps2dKbd_IsResetting(void);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if the host has enabled scanning. Key events sent while
+ *  disabled are discarded.
+ *
+ * Parameters:
+ *  n/a
+ * 
+ * Returns: bool
+ *  true  - if scanning is enabled
+ *  false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Ps2dKbd_IsEnabled(void);
+
 /* -----------------------------------------------------------------------
  * Description:
  *  Periodic update to allow the PS/2 device subsystem to perform any
@@ -24,6 +24,19 @@
     #define PS2D_KBD_INTER_BYTE_DELAY 500UL  /* Model M uses about 1ms */  
 #endif
 
+/* Fast boot: relaxes the POR/BAT duration limits and ends the power-on
+ * POR/BAT wait early once a running host has been detected on the bus.
+ * A BAT following a reset command from the host always runs in full. */
+#ifndef PS2D_KBD_FAST_BOOT
+    #define PS2D_KBD_FAST_BOOT 0
+#endif
+
+/* Time the bus must be continuously idle before the host is considered
+ * to be up and ready to receive the BAT result */
+#ifndef PS2D_KBD_FAST_BOOT_HOST_IDLE
+    #define PS2D_KBD_FAST_BOOT_HOST_IDLE 10UL /* milliseconds */
+#endif
+
 #ifndef PS2D_KBD_DEVICE_ID 
     #define PS2D_KBD_DEVICE_ID {0xAB, 0x83}
 #endif
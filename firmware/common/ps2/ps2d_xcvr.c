@@ -39,6 +39,17 @@
  *   and error status is set and the timer stopped. Once the entire byte
  *   has been successfully received, it is loaded into the receive buffer.
  *
+ * Idle mode:
+ *   Once the bus has been idle for PS2D_XCVR_IDLE_MODE_DELAY with nothing
+ *   to send, the bus timer is slowed and each interrupt advances the system
+ *   tick and idle count by PS2D_XCVR_IDLE_TICKS. The timer returns to full
+ *   rate when data is queued for transmission, when the bus leaves the
+ *   idle state or, if the HAL provides it, from the CLOCK/DATA wake ISR.
+ *
+ * System tick:
+ *   The bus timer drives the system tick, one tick per interrupt. The 
+ *   timer keeps running while the transceiver is disabled.
+ *
  * License:
  *  Copyright (c) 2015, Engicoder
  *  All rights reserved.
@@ -49,6 +60,7 @@
 #include "ps2d_xcvr_hal.h"
 #include "ps2_command.h"
 #include "atomic_hal.h"
+#include "system_tick.h"
 
 #include "console.h"
 
@@ -70,8 +82,14 @@ typedef enum
 /* Provides status to the caller regarding the state of Ps2dXcvr */
 volatile uint8_t _ps2dXcvrStatus = (uint8_t)PS2D_XCVR_STATUS_NONE;
 
-/* Provides a time base for calculating durations */
-volatile uint16_t _ps2dXcvrClockCount = 0;
+#if SYSTEM_TICK_PERIOD_US != PS2_CLOCK_PERIOD / 4
+    #error "SYSTEM_TICK_PERIOD_US must be a quarter of PS2_CLOCK_PERIOD."
+#endif
+
+/* The bus timer drives the system tick */
+#if PS2D_XCVR_TICK_CYCLES != SYSTEM_TICK_PERIOD_US * (F_CPU / 1000000UL)
+    #error "The bus timer period must equal SYSTEM_TICK_PERIOD_US."
+#endif
 
 /* Clock count since the bus last became idle */
 volatile uint16_t _ps2dXcvrIdleCount = 0;
@@ -79,6 +97,15 @@ volatile uint16_t _ps2dXcvrIdleCount = 0;
 /* Tracks the state of the PS/2 bus */
 static volatile XcvrState _xcvrState = DISABLED;
 
+/* Set while the bus timer is slowed in idle mode */
+static volatile bool _busTimerIdle = false;
+
+/* Worst case bus timer ISR delay in bus timer counts */
+static volatile uint8_t _tickDelayMax = 0;
+static uint8_t _tickDelayReported = 0;
+
+#define IDLE_MODE_CLOCKS PS2D_XCVR_INTERVAL_MS_TO_CLK_COUNT(PS2D_XCVR_IDLE_MODE_DELAY)
+
 /* Used to transfer data in an out of the interrupt driven 
  * transmission routines */
 static volatile uint8_t _xmitBuffer;
@@ -99,6 +126,9 @@ static inline void XcvrStateSet(XcvrState state)  __attribute__((always_inline))
 static inline bool XcvrStateIs(XcvrState state)  __attribute__((always_inline));
 static inline XcvrState XcvrStateGet(void) __attribute__((always_inline));
 
+static inline void ClockCountsAdd(uint8_t clocks) __attribute__((always_inline));
+static inline void BusTimerWake(void) __attribute__((always_inline));
+
 
 /* ------------------------------------------------------------------------
  *  Initialize the PS/2 Device Trancevier
@@ -120,8 +150,8 @@ void Ps2dXcvr_Init(void)
 
     StatusReset();
 
-    _ps2dXcvrClockCount = 0;
     _ps2dXcvrIdleCount = 0;
+    _busTimerIdle = false;
 	Ps2dXcvrHal_BusTimerStart();        
 
     CONSOLE_SEND8(CON_SRC_PS2D_XCVR, CON_SEV_TRACE_INFO, CON_MSG_PS2D_XCVR_CLK_PERIOD, PS2_CLOCK_PERIOD);
@@ -169,6 +199,10 @@ void Ps2dXcvr_Enable(void)
   
 }
 
+/* ------------------------------------------------------------------------
+ *  Disables the Transceiver. The bus timer keeps running as it drives the
+ *  system tick.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Ps2dXcvr_Disable(void)
 {
     XcvrStateSet(DISABLED);
@@ -177,7 +211,10 @@ void Ps2dXcvr_Disable(void)
     Ps2dXcvrHal_ClockHigh();
     Ps2dXcvrHal_DataHigh();
 
-    Ps2dXcvrHal_BusTimerStop();
+    ATOMIC_RESTORE()
+    {
+        BusTimerWake();
+    }
 }
 
 
@@ -192,10 +229,31 @@ void Ps2dXcvr_RetransmitLastByte(void)
 
 	StatusSet(PS2D_XCVR_XMIT_BUFFER_FULL);
 
+    ATOMIC_RESTORE()
+    {
+        BusTimerWake();
+    }
+
 	CONSOLE_SEND8(CON_SRC_PS2D_XCVR, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_XCVR_REXMIT, _xmitBuffer);
     
 }
 
+/* ------------------------------------------------------------------------
+ *  Report a new worst case bus timer ISR delay
+ *   - Sent with the timer counts per microsecond for conversion
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void Ps2dXcvr_ReportTickDelay(void)
+{
+    uint8_t tickDelay = _tickDelayMax;
+
+    if (!PS2D_XCVR_TICK_DELAY_STATS || tickDelay == _tickDelayReported)
+        return;
+
+    _tickDelayReported = tickDelay;
+
+    CONSOLE_SEND88(CON_SRC_PS2D_XCVR, CON_SEV_TRACE_INFO, CON_MSG_PS2D_XCVR_TICK_DELAY, tickDelay, PS2D_XCVR_TIMER_COUNTS_PER_US);
+}
+
 /* ------------------------------------------------------------------------
  *  Determins if the bus is idle
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
@@ -225,6 +283,10 @@ bool Ps2dXcvr_TransmitDataAsync (uint8_t data)
                 _lastXmit = data;
                 _xmitBuffer = data;
                 StatusSet(PS2D_XCVR_XMIT_BUFFER_FULL);
+                ATOMIC_RESTORE()
+                {
+                    BusTimerWake();
+                }
             	CONSOLE_SEND8(CON_SRC_PS2D_XCVR, CON_SEV_TRACE_EVENT, CON_MSG_PS2D_XCVR_XMIT, data);
                 result = true;
             } else {
@@ -303,6 +365,41 @@ static inline XcvrState XcvrStateGet(void)
     return _xcvrState;
 }
 
+/* ------------------------------------------------------------------------
+ *  Advance the system tick and idle count, the idle count saturates.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void ClockCountsAdd(uint8_t clocks)
+{
+    uint16_t idleCount = _ps2dXcvrIdleCount + clocks;
+
+    SystemTick_Advance(clocks);
+    _ps2dXcvrIdleCount = (idleCount < clocks) ? UINT16_MAX : idleCount;
+}
+
+/* ------------------------------------------------------------------------
+ *  Return the bus timer to full rate if it is in idle mode.
+ *   - Must be called with interrupts disabled
+ *   - Time elapsed since the last idle interrupt is added to the tick
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void BusTimerWake(void)
+{
+    if (_busTimerIdle)
+    {
+        _busTimerIdle = false;
+        ClockCountsAdd(Ps2dXcvrHal_BusTimerWake());
+    }
+}
+
+#ifdef PS2D_XCVR_WAKE_ISR
+/* ------------------------------------------------------------------------
+ *  Triggered by a change on the CLOCK or DATA line while in idle mode.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+PS2D_XCVR_WAKE_ISR()
+{
+    BusTimerWake();
+}
+#endif
+
  /* ------------------------------------------------------------------------
  *  ISR used to manage the PS/2 bus, including transmitting and receiving  
  *  data as well as checking bus status.
@@ -311,6 +408,7 @@ static inline XcvrState XcvrStateGet(void)
  *   triggered 4 times per cycle of the CLOCK line. 
  *   The host latches/reads data on the rising edge of the clock pulse, 
  *   and the device does the same on falling edge.    
+ *   In idle mode it is triggered once every PS2D_XCVR_IDLE_TICKS periods.
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 PS2D_XCVR_CLOCK_ISR()
 {
@@ -329,16 +427,45 @@ PS2D_XCVR_CLOCK_ISR()
     Ps2dXcvrHal_DbgTimingLow();
 #endif
 
-    _ps2dXcvrClockCount++;
+    /* The timer restarts from 0 on compare match, the current count is 
+     * the delay before this ISR started */
+    if (PS2D_XCVR_TICK_DELAY_STATS && !_busTimerIdle) {
+        uint8_t tickDelay = Ps2dXcvrHal_BusTimerCount();
+        if (tickDelay > _tickDelayMax)
+            _tickDelayMax = tickDelay;
+    }
+
+    if (_busTimerIdle) {
+        ClockCountsAdd(PS2D_XCVR_IDLE_TICKS);
+    } else {
+        SystemTick_Advance(1);
+    }
 
     Ps2BusState busState = Ps2dXcvrHal_BusState();
 
     switch(_xcvrState)
     {
         case DISABLED:
+            /* Track bus idle time while disabled, this allows a running 
+             * host to be detected before the transceiver is enabled. */
+            if (busState == PS2_BUS_STATE_IDLE) {
+                if (_ps2dXcvrIdleCount < UINT16_MAX)
+                    _ps2dXcvrIdleCount++;
+            } else {
+                _ps2dXcvrIdleCount = 0;
+            }
             break;
 
         case IDLE:
+            if (_busTimerIdle)
+            {
+                /* Counts were advanced above, resume full rate if there
+                 * is anything other than idle time to track */
+                if (busState == PS2_BUS_STATE_IDLE && !StatusIsSet(PS2D_XCVR_XMIT_BUFFER_FULL))
+                    break;
+                BusTimerWake();
+            }
+
             if (busState == PS2_BUS_STATE_IDLE)
             {
                 /* If data is ready to be sent, iniate transmission */
@@ -353,6 +480,12 @@ PS2D_XCVR_CLOCK_ISR()
                 } else {
                     if (_ps2dXcvrIdleCount < UINT16_MAX)
                         _ps2dXcvrIdleCount++;
+
+                    if (PS2D_XCVR_IDLE_MODE_DELAY && _ps2dXcvrIdleCount >= IDLE_MODE_CLOCKS) {
+                        _busTimerIdle = true;
+                        Ps2dXcvrHal_BusTimerIdle();
+                        break;
+                    }
                 }       
             } else {
                 _ps2dXcvrIdleCount = 0;
@@ -38,11 +38,8 @@ typedef enum Ps2dXcvrStatus
 #define PS2D_XCVR_INTERVAL_US_TO_CLK_COUNT(interval) ((uint16_t)(((uint32_t)interval * 4UL) / (uint32_t)PS2_CLOCK_PERIOD))
 #define PS2D_XCVR_INTERVAL_MS_TO_CLK_COUNT(interval) ((uint16_t)(((uint32_t)interval * 1000UL * 4UL) / (uint32_t)PS2_CLOCK_PERIOD))
 
-#define PS2D_XCVR_CLOCKS_PER_MS (4000UL / PS2_CLOCK_PERIOD)
-
 /* === External Variables ============================================== */
 extern volatile uint8_t _ps2dXcvrStatus;
-extern volatile uint16_t _ps2dXcvrClockCount;
 extern volatile uint16_t _ps2dXcvrIdleCount;
 
 /* === Forward declarations ============================================ */
@@ -190,25 +187,17 @@ static inline bool Ps2dXcvr_DataReceived(void)
 
 /* -----------------------------------------------------------------------
  * Description:
- *  Gets the number of clock counts. This value can be compared to the
- *  result of earlier calls to determine duration.
- *  Note: Clock counts will wrap after ~2.6 seconds.
+ *  Sends the worst case bus timer ISR delay to the console when it has
+ *  increased since the last report. Does nothing unless 
+ *  PS2D_XCVR_TICK_DELAY_STATS is enabled.
  *
  * Parameters:
  *  n/a
  *
- * Returns: bool
- *  The current clock count
+ * Returns:
+ *  n/a
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline uint16_t Ps2dXcvr_GetClockCount(void)
-{
-    uint16_t clockCount = 0;
-    ATOMIC()
-    {
-        clockCount = _ps2dXcvrClockCount;
-    }
-    return clockCount;    
-}
+void Ps2dXcvr_ReportTickDelay(void);
 
 /* -----------------------------------------------------------------------
  * Description:
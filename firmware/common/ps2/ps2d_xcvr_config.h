@@ -17,4 +17,20 @@
 
 #include "config.h"
 
+/* Track the worst case delay between the bus timer compare match and the
+ * start of the bus timer ISR, caused by other interrupts */
+#ifndef PS2D_XCVR_TICK_DELAY_STATS
+    #ifdef USE_CONSOLE
+        #define PS2D_XCVR_TICK_DELAY_STATS 1
+    #else
+        #define PS2D_XCVR_TICK_DELAY_STATS 0
+    #endif
+#endif
+
+/* Slow the bus timer once the bus has been idle this long with nothing to
+ * send. 0 keeps the bus timer at full rate. */
+#ifndef PS2D_XCVR_IDLE_MODE_DELAY
+    #define PS2D_XCVR_IDLE_MODE_DELAY 50U /* milliseconds */
+#endif
+
 #endif /* PS2D_XCVR_CONFIG_H_ */
\ No newline at end of file
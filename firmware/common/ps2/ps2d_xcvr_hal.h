@@ -52,6 +52,36 @@ static inline void Ps2dXcvrHal_BusTimerStart(void);
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 static inline void Ps2dXcvrHal_BusTimerStop(void);
 
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Slows the running PS/2 bus timer while the bus is idle. Each interrupt
+ *  then accounts for PS2D_XCVR_IDLE_TICKS bus timer periods. If the HAL
+ *  supports it, a change on the CLOCK or DATA line triggers the wake ISR.
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void Ps2dXcvrHal_BusTimerIdle(void);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Returns the PS/2 bus timer to full rate after Ps2dXcvrHal_BusTimerIdle.
+ *
+ * Returns:
+ *  The number of bus timer periods elapsed since the last idle interrupt.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline uint8_t Ps2dXcvrHal_BusTimerWake(void);
+
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Gets the PS/2 bus timer count since the last bus timer interrupt. The
+ *  count advances PS2D_XCVR_TIMER_COUNTS_PER_US times per microsecond.
+ *
+ * Returns:
+ *  The bus timer count.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline uint8_t Ps2dXcvrHal_BusTimerCount(void) __attribute__((always_inline));
 
 /* -----------------------------------------------------------------------
  * Description:
@@ -155,6 +185,10 @@ static inline Ps2BusState Ps2dXcvrHal_BusState(void) __attribute__((always_inlin
     #error PS2D_XCVR_CLOCK_ISR not defined.
 #endif
 
+#if !defined(PS2D_XCVR_IDLE_TICKS)
+    #error PS2D_XCVR_IDLE_TICKS not defined.
+#endif
+
 
 
 #endif /* PS2D_XCVR_HAL_H_ */
\ No newline at end of file
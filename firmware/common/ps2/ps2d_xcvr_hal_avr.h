@@ -66,6 +66,31 @@
     #error PS2D_XCVR_DATA_INTERRUPT_VECTOR not defined
 #endif
 
+/* The optional wake interrupt is a pin change interrupt covering the
+ * CLOCK and DATA lines */
+#ifdef PS2D_XCVR_WAKE_INTERRUPT_VECTOR
+
+    #ifndef PS2D_XCVR_WAKE_PCMSK
+        #error PS2D_XCVR_WAKE_PCMSK not defined
+    #endif
+
+    #ifndef PS2D_XCVR_WAKE_PCIE
+        #error PS2D_XCVR_WAKE_PCIE not defined
+    #endif
+
+    #ifndef PS2D_XCVR_WAKE_MASK
+        #error PS2D_XCVR_WAKE_MASK not defined
+    #endif
+
+    #if defined (__AVR_ATtiny85__)
+        #define PS2D_XCVR_WAKE_PCICR GIMSK
+        #define PS2D_XCVR_WAKE_PCIFR GIFR
+    #else
+        #define PS2D_XCVR_WAKE_PCICR PCICR
+        #define PS2D_XCVR_WAKE_PCIFR PCIFR
+    #endif
+#endif
+
 #ifdef DEBUG_TIMING
 
     #ifndef PS2D_XCVR_DBG_TIMING_PORT
@@ -83,8 +108,20 @@
 
 
 
-/* This transceiver ISR is called 4 times per clock period */
-#define PS2D_XCVR_PULSE_WIDTH (F_CPU/1000000U/CLOCK_PRESCALER * (PS2_CLOCK_PERIOD/4))
+/* Timer0 runs from Clk/8 while the bus is active */
+#define PS2D_XCVR_TIMER_PRESCALER 8UL
+
+#define PS2D_XCVR_TIMER_COUNTS_PER_US (F_CPU/1000000U/PS2D_XCVR_TIMER_PRESCALER)
+
+/* This transceiver ISR is called 4 times per clock period. In CTC mode 
+ * the timer period is OCR0A + 1 counts. */
+#define PS2D_XCVR_PULSE_WIDTH (PS2D_XCVR_TIMER_COUNTS_PER_US * (PS2_CLOCK_PERIOD/4) - 1)
+
+/* CPU cycles per bus timer interrupt, the system tick period */
+#define PS2D_XCVR_TICK_CYCLES (PS2D_XCVR_TIMER_PRESCALER * (PS2D_XCVR_PULSE_WIDTH + 1UL))
+
+/* While idle the timer runs from Clk/256 instead of Clk/8 */
+#define PS2D_XCVR_IDLE_TICKS 32U
 
 
 static inline void Ps2dXcvrHal_BusTimerInit(void)
@@ -130,6 +167,9 @@ static inline void Ps2dXcvrHal_BusTimerStart(void)
 
 static inline void Ps2dXcvrHal_BusTimerStop(void)
 {
+#ifdef PS2D_XCVR_WAKE_INTERRUPT_VECTOR
+    PS2D_XCVR_WAKE_PCICR &= ~(1 << PS2D_XCVR_WAKE_PCIE);
+#endif
 
     /* Stop timer by selecting no clock source */
     TCCR0B = 0;
@@ -142,6 +182,44 @@ static inline void Ps2dXcvrHal_BusTimerStop(void)
 #endif
 }
 
+static inline void Ps2dXcvrHal_BusTimerIdle(void)
+{
+    /* Clk/256 source, the compare value is unchanged */
+    TCCR0B = (1 << CS02);
+
+#ifdef PS2D_XCVR_WAKE_INTERRUPT_VECTOR
+    PS2D_XCVR_WAKE_PCIFR = (1 << PS2D_XCVR_WAKE_PCIE);
+    PS2D_XCVR_WAKE_PCMSK |= PS2D_XCVR_WAKE_MASK;
+    PS2D_XCVR_WAKE_PCICR |= (1 << PS2D_XCVR_WAKE_PCIE);
+#endif
+}
+
+static inline uint8_t Ps2dXcvrHal_BusTimerWake(void)
+{
+#ifdef PS2D_XCVR_WAKE_INTERRUPT_VECTOR
+    PS2D_XCVR_WAKE_PCICR &= ~(1 << PS2D_XCVR_WAKE_PCIE);
+#endif
+
+    /* Convert the partial idle period to full rate periods */
+    uint8_t elapsed = (uint8_t)((uint16_t)TCNT0 * PS2D_XCVR_IDLE_TICKS / (PS2D_XCVR_PULSE_WIDTH + 1));
+
+    /* Restart at full rate from Clk/8 */
+    TCNT0 = 0;
+#if defined (__AVR_ATmega328P__) || defined (__AVR_ATmega32U4__)
+    TIFR0 = (1<<OCF0A);
+#elif defined (__AVR_ATtiny85__)
+    TIFR = (1<<OCF0A);
+#endif
+    TCCR0B = (1 << CS01);
+
+    return elapsed;
+}
+
+static inline uint8_t Ps2dXcvrHal_BusTimerCount(void)
+{
+    return TCNT0;
+}
+
 static inline bool Ps2dXcvrHal_ClockIsHigh(void)
 {
     return (PS2D_XCVR_CLOCK_PINS & (1 << PS2D_XCVR_CLOCK_BIT));
@@ -214,6 +292,10 @@ static inline Ps2BusState Ps2dXcvrHal_BusState(void)
 #define PS2D_XCVR_CLOCK_ISR() ISR(PS2D_XCVR_CLOCK_INTERRUPT_VECTOR)
 #define PS2D_XCVR_DATA_ISR() ISR(PS2D_XCVR_DATA_INTERRUPT_VECTOR)
 
+#ifdef PS2D_XCVR_WAKE_INTERRUPT_VECTOR
+    #define PS2D_XCVR_WAKE_ISR() ISR(PS2D_XCVR_WAKE_INTERRUPT_VECTOR)
+#endif
+
 #ifdef DEBUG_TIMING
 
 static inline void Ps2dXcvrHal_DbgTimingInit(void)
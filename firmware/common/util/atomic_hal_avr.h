@@ -12,6 +12,7 @@
 #include <util/atomic.h>
 
 #define ATOMIC() ATOMIC_BLOCK(ATOMIC_FORCEON)
+#define ATOMIC_RESTORE() ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 
 
 #endif /* ATOMIC_HAL_AVR_H_ */
\ No newline at end of file
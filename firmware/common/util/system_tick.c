@@ -0,0 +1,15 @@
+/* =======================================================================
+ * system_tick.c
+ *
+ * Purpose:
+ *  Storage for the monotonic system tick.
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+#include "system_tick.h"
+
+volatile SystemTick _systemTick = 0;
@@ -0,0 +1,141 @@
+/* =======================================================================
+ * system_tick.h
+ *
+ * Purpose:
+ *  Monotonic 32 bit system tick used by all subsystems for timeouts, 
+ *  intervals and message timestamps.
+ *
+ * Operational Summary:
+ *  The tick is advanced by the interrupt of the subsystem that owns the
+ *  periodic hardware timer, currently the PS/2 bus timer, and has a 
+ *  period of SYSTEM_TICK_PERIOD_US. While the bus timer is in idle mode 
+ *  the tick advances in steps of PS2D_XCVR_IDLE_TICKS. At 20us the tick 
+ *  wraps after ~23.8 hours. Deadlines are compared using the signed 
+ *  difference, so any interval shorter than half the wrap period is 
+ *  handled across a wrap.
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+#ifndef SYSTEM_TICK_H_
+#define SYSTEM_TICK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "atomic_hal.h"
+
+#ifndef SYSTEM_TICK_PERIOD_US
+    #define SYSTEM_TICK_PERIOD_US 20U /* Microseconds */
+#endif
+
+#define SYSTEM_TICKS_PER_MS (1000UL / SYSTEM_TICK_PERIOD_US)
+
+/* Convert a time interval to ticks, rounding up */
+#define SYSTEM_TICK_US_TO_TICKS(interval) ((SystemTick)(((uint32_t)(interval) + SYSTEM_TICK_PERIOD_US - 1) / SYSTEM_TICK_PERIOD_US))
+#define SYSTEM_TICK_MS_TO_TICKS(interval) ((SystemTick)((uint32_t)(interval) * SYSTEM_TICKS_PER_MS))
+
+typedef uint32_t SystemTick;
+
+extern volatile SystemTick _systemTick;
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Advances the system tick. Must only be called by the interrupt that
+ *  drives the tick.
+ *
+ * Parameters:
+ *  ticks - number of tick periods elapsed
+ *
+ * Returns:
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void SystemTick_Advance(uint8_t ticks)
+{
+    _systemTick += ticks;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Gets the current system tick. Safe to call with interrupts disabled.
+ *
+ * Returns: SystemTick
+ *  The current tick count
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline SystemTick SystemTick_Now(void)
+{
+    SystemTick now;
+    ATOMIC_RESTORE()
+    {
+        now = _systemTick;
+    }
+    return now;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Gets the number of ticks elapsed since an earlier tick.
+ *
+ * Parameters:
+ *  since - tick returned by an earlier call to SystemTick_Now()
+ *
+ * Returns: SystemTick
+ *  The elapsed ticks
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline SystemTick SystemTick_Elapsed(SystemTick since)
+{
+    return SystemTick_Now() - since;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Gets a deadline the specified number of ticks from now.
+ *
+ * Parameters:
+ *  ticks - interval until the deadline
+ *
+ * Returns: SystemTick
+ *  The deadline
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline SystemTick SystemTick_Deadline(SystemTick ticks)
+{
+    return SystemTick_Now() + ticks;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if a deadline has been reached.
+ *
+ * Parameters:
+ *  deadline - deadline returned by SystemTick_Deadline()
+ *
+ * Returns: bool
+ *  true  - if the deadline has been reached
+ *  false - otherwise
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline bool SystemTick_DeadlinePassed(SystemTick deadline)
+{
+    return (int32_t)(SystemTick_Now() - deadline) >= 0;
+}
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Gets the number of ticks remaining until a deadline, e.g. to determine
+ *  how long the processor may sleep.
+ *
+ * Parameters:
+ *  deadline - deadline returned by SystemTick_Deadline()
+ *
+ * Returns: SystemTick
+ *  The ticks remaining, 0 if the deadline has been reached
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline SystemTick SystemTick_Remaining(SystemTick deadline)
+{
+    int32_t remaining = (int32_t)(deadline - SystemTick_Now());
+    return remaining > 0 ? (SystemTick)remaining : 0;
+}
+
+#endif /* SYSTEM_TICK_H_ */
@@ -6,6 +6,10 @@ typedef enum _ConsoleMessageIdXthKbd
 {
     CON_MSG_XTH_KBD_RECV_OVERFLOW,
     CON_MSG_XTH_KBD_DETECTED,
+    CON_MSG_XTH_KBD_PROTOCOL,
+    CON_MSG_XTH_KBD_CHATTER,
+    CON_MSG_XTH_KBD_DEBOUNCE_STATS,
+    CON_MSG_XTH_KBD_SCAN_CODE,
     
 } ConsoleMessageIdXthKbd;
 
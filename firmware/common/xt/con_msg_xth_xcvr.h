@@ -8,6 +8,10 @@ typedef enum _ConsoleMessageIdXthXcvr
     CON_MSG_XTH_XCVR_HARD_RESET,
     CON_MSG_XTH_XCVR_RECV_SCODE,
     CON_MSG_XTH_XCVR_BAD_START_BIT,
+    CON_MSG_XTH_XCVR_STATS_PERIOD,
+    CON_MSG_XTH_XCVR_STATS_FRAME,
+    CON_MSG_XTH_XCVR_STATS_RECV,
+    CON_MSG_XTH_XCVR_PROTOCOL_RELOCK,
     
 } ConsoleMessageIdXthXcvr;
 
@@ -105,8 +105,46 @@ typedef enum
     XT_SC_KP_3          = 0x51,
     XT_SC_KP_0          = 0x52,
     XT_SC_KP_DOT        = 0x53,
-    XT_SC_MAX_CODE      = 0x53,
+    XT_SC_SYSREQ        = 0x54,
+    XT_SC_INTL_BACKSLASH = 0x56,
+    XT_SC_F11           = 0x57,
+    XT_SC_F12           = 0x58,
+    XT_SC_MAX_BASE_CODE = 0x58,
+
+    /* Extended keys. Enhanced keyboards send these as E0 or E1 prefixed
+     * sequences which XthKbd folds into a single code following the 
+     * base codes, so they index the keymap directly. */
+    XT_SC_KP_ENTER      = 0x59,     /* E0 1C */
+    XT_SC_RCONTROL      = 0x5A,     /* E0 1D */
+    XT_SC_KP_SLASH      = 0x5B,     /* E0 35 */
+    XT_SC_PRINT_SCREEN  = 0x5C,     /* E0 37 */
+    XT_SC_RALT          = 0x5D,     /* E0 38 */
+    XT_SC_BREAK         = 0x5E,     /* E0 46, Ctrl + Pause */
+    XT_SC_HOME          = 0x5F,     /* E0 47 */
+    XT_SC_UP            = 0x60,     /* E0 48 */
+    XT_SC_PAGE_UP       = 0x61,     /* E0 49 */
+    XT_SC_LEFT          = 0x62,     /* E0 4B */
+    XT_SC_RIGHT         = 0x63,     /* E0 4D */
+    XT_SC_END           = 0x64,     /* E0 4F */
+    XT_SC_DOWN          = 0x65,     /* E0 50 */
+    XT_SC_PAGE_DOWN     = 0x66,     /* E0 51 */
+    XT_SC_INSERT        = 0x67,     /* E0 52 */
+    XT_SC_DELETE        = 0x68,     /* E0 53 */
+    XT_SC_LGUI          = 0x69,     /* E0 5B */
+    XT_SC_RGUI          = 0x6A,     /* E0 5C */
+    XT_SC_APPLICATION   = 0x6B,     /* E0 5D */
+    XT_SC_PAUSE         = 0x6C,     /* E1 1D 45 */
+    XT_SC_MAX_CODE      = 0x6C,
+
+    /* Base bytes of the GUI and Menu keys, only ever sent after E0. They
+     * overlap the folded codes above. */
+    XT_SC_LGUI_BASE     = 0x5B,
+    XT_SC_RGUI_BASE     = 0x5C,
+    XT_SC_APPLICATION_BASE = 0x5D,
+
     XT_SC_BAT_COMPLETE  = 0xAA,   
+    XT_SC_PREFIX_E0     = 0xE0,
+    XT_SC_PREFIX_E1     = 0xE1,
 } XtScanCode;
 
 #endif /* XT_SCANCODE_H_ */
\ No newline at end of file
@@ -16,98 +16,418 @@
 #include "common.h"
 #include "circular_buffer.h"
 #include "xth_xcvr.h"
+#include "xth_xcvr_config.h"
+#include "xt_scancode.h"
 #include "console.h"
 #include "con_msg_xth_kbd.h"
 #include "bit_array.h"
+#include "system_tick.h"
 
 #define XTH_KBD_ERROR_THRESHOLD  10
 
-#ifndef XTH_KBD_FWD_TYPEMATIC
-    #define XTH_KBD_FWD_TYPEMATIC 0
+/* Number of scan codes received between reports of the XT receive
+ * statistics */
+#ifndef XTH_KBD_STATS_INTERVAL
+    #define XTH_KBD_STATS_INTERVAL 64
 #endif
 
-CircularBuffer _scanCodeBuffer;
-uint8_t _scanCodeBufferStorage[XTH_RECV_BUFFER_SIZE];
-bool _enabled = false;
-uint8_t _errorCount = 0;
-bool _detected = false;
-BitArray _keyState;
-uint8_t _keyStateStorage[BIT_ARRAY_STORAGE_SIZE(XT_SC_MAX_CODE)];
+/* Make/break transitions of a key within this many milliseconds of its
+ * previous transition are treated as chatter and filtered, 0 disables */
+#ifndef XTH_KBD_DEBOUNCE_MS
+    #define XTH_KBD_DEBOUNCE_MS 5U
+#endif
+
+/* Number of keys debounced at once, keys changing while all are in use
+ * are passed on unfiltered */
+#ifndef XTH_KBD_DEBOUNCE_SLOTS
+    #define XTH_KBD_DEBOUNCE_SLOTS 4
+#endif
+
+#define DEBOUNCE_TICKS ((uint16_t)SYSTEM_TICK_MS_TO_TICKS(XTH_KBD_DEBOUNCE_MS))
+
+#if XTH_KBD_DEBOUNCE_MS * SYSTEM_TICKS_PER_MS > 0x7FFF
+    #error "XTH_KBD_DEBOUNCE_MS is too long for the 16 bit debounce timestamp."
+#endif
+
+/* Position within an E0 or E1 prefixed scan code sequence */
+typedef enum
+{
+    PREFIX_NONE,
+    PREFIX_E0,          /* E0 received, extended code follows */
+    PREFIX_E1,          /* E1 received, 1D/9D follows */
+    PREFIX_E1_CONTROL,  /* E1 1D/9D received, 45/C5 follows */
+} XthKbdPrefix;
+
+/* Key with a recent transition. The window restarts on every transition
+ * received within it. */
+typedef struct _XthKbdDebounce
+{
+    uint8_t code;       /* Base scan code, XT_SC_NONE when unused */
+    bool isDown;        /* Last state received from the keyboard */
+    uint16_t stamp;     /* Low bits of the system tick of the transition */
+} XthKbdDebounce;
+
+/* State of a single keyboard, one per transceiver instance */
+typedef struct _XthKbd
+{
+    CircularBuffer scanCodeBuffer;
+    uint8_t scanCodeBufferStorage[XTH_RECV_BUFFER_SIZE];
+    uint8_t errorCount;
+    bool detected;
+    XthKbdPrefix prefix;
+    BitArray keyState;
+    uint8_t keyStateStorage[BIT_ARRAY_STORAGE_SIZE(XT_SC_MAX_CODE + 1U)];
+#if XTH_KBD_DEBOUNCE_MS > 0
+    XthKbdDebounce debounce[XTH_KBD_DEBOUNCE_SLOTS];
+    uint16_t chatterCount;  /* Transitions filtered */
+    uint16_t settledCount;  /* Filtered states passed on once settled */
+#endif
+#ifdef USE_CONSOLE
+    uint8_t statsCount;
+#endif
+} XthKbd;
 
-OnScanCode _scanCodeHandler = (OnScanCode)0;
+static XthKbd _kbd[XTH_XCVR_INSTANCES];
+static bool _enabled = false;
+
+static OnScanCode _scanCodeHandler = (OnScanCode)0;
+
+static void KbdTask(uint8_t instance);
+static uint8_t DecodePrefix(XthKbd* kbd, uint8_t scanCode);
+static uint8_t ExtendedCode(uint8_t baseCode);
+static bool Debounce(XthKbd* kbd, uint8_t scanCode);
+static void DebounceSettle(XthKbd* kbd);
+static void DebounceClear(XthKbd* kbd);
 
 void XthKbd_Init(void)
 {
-    CircularBuffer_Init(&_scanCodeBuffer, _scanCodeBufferStorage, XTH_RECV_BUFFER_SIZE);
-    BitArray_Init(&_keyState, _keyStateStorage, sizeof (_keyStateStorage));
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++)
+    {
+        XthKbd* kbd = &_kbd[instance];
+        CircularBuffer_Init(&kbd->scanCodeBuffer, kbd->scanCodeBufferStorage, XTH_RECV_BUFFER_SIZE);
+        BitArray_Init(&kbd->keyState, kbd->keyStateStorage, sizeof (kbd->keyStateStorage));
+    }
     XthXcvr_Init();
 }
 
 void XthKbd_Enable(void)
 {
-    XthXcvr_Enable();
-    CircularBuffer_Clear(&_scanCodeBuffer);
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++)
+    {
+        XthKbd* kbd = &_kbd[instance];
+        XthXcvr_Enable(instance);
+        CircularBuffer_Clear(&kbd->scanCodeBuffer);
+        kbd->detected = false;
+        kbd->prefix = PREFIX_NONE;
+        BitArray_ClearAll(&kbd->keyState);
+        DebounceClear(kbd);
+    }
     _enabled = true;
-    _detected = false;
-    BitArray_ClearAll(&_keyState);
 }
 
 
 void XthKbd_Disable(void)
 {
     _enabled = false;
-    XthXcvr_Disable();
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++)
+        XthXcvr_Disable(instance);
 }
 
 void XthKbd_Task(void)
 {
-    if (!_enabled || !XthXcvr_StatusReady())
+    if (!_enabled)
+        return;
+
+    /* Runs the keyboard reset sequence as well as decoding */
+    XthXcvr_Update();
+
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++)
+        KbdTask(instance);
+}
+
+static void KbdTask(uint8_t instance)
+{
+    XthKbd* kbd = &_kbd[instance];
+
+    if (!XthXcvr_StatusReady(instance))
         return;
-    
-    if (!_detected)
+
+    if (!kbd->detected)
     {
-        if (XthXcvr_StatusKeyboardDetected())
+        if (XthXcvr_StatusKeyboardDetected(instance))
         {
-            _detected = true;
+            kbd->detected = true;
             CONSOLE_SEND0(CON_SRC_XTH_KBD, CON_SEV_TRACE_EVENT, CON_MSG_XTH_KBD_DETECTED);
+            CONSOLE_SEND1616(CON_SRC_XTH_KBD, CON_SEV_TRACE_EVENT, CON_MSG_XTH_KBD_PROTOCOL, XthXcvr_StartBits(instance), XthXcvr_ClockPeriod(instance));
+            XthXcvr_ReportStats(instance);
         }
     }
 
-    if (XthXcvr_StatusIsOverflow())
+    if (XthXcvr_StatusIsOverflow(instance))
     {
         CONSOLE_SEND0(CON_SRC_XTH_KBD, CON_SEV_TRACE_EVENT, CON_MSG_XTH_KBD_RECV_OVERFLOW);
-        _errorCount++;
-        if (_errorCount > XTH_KBD_ERROR_THRESHOLD)
+        XthXcvr_ReportStats(instance);
+        XthXcvr_ClearOverflow(instance);
+        kbd->errorCount++;
+        if (kbd->errorCount > XTH_KBD_ERROR_THRESHOLD)
         {
-            XthXcvr_SoftReset();
-            _errorCount = 0;
+            XthXcvr_SoftReset(instance);
+            kbd->errorCount = 0;
+            return;
         }
     }
-    else if (XthXcvr_StatusDataReceived())
+
+    DebounceSettle(kbd);
+
+    /* Leave data in the transceiver while the scan code buffer is full. 
+     * The XT clock is held low once the transceiver queue fills, which 
+     * prevents the keyboard from sending further scan codes. */
+    while (XthXcvr_StatusDataReceived(instance) && !CircularBuffer_IsFull(&kbd->scanCodeBuffer))
     {
-        uint8_t scanCode = XthXcvr_ReadReceivedData();
-        if (scanCode != XT_SC_NONE)
+        uint8_t scanCode = DecodePrefix(kbd, XthXcvr_ReadReceivedData(instance));
+
+#ifdef USE_CONSOLE
+        if (++kbd->statsCount >= XTH_KBD_STATS_INTERVAL)
+        {
+            kbd->statsCount = 0;
+            XthXcvr_ReportStats(instance);
+#if XTH_KBD_DEBOUNCE_MS > 0
+            CONSOLE_SEND1616(CON_SRC_XTH_KBD, CON_SEV_TRACE_INFO, CON_MSG_XTH_KBD_DEBOUNCE_STATS, kbd->chatterCount, kbd->settledCount);
+#endif
+        }
+#endif
+
+        if (scanCode != XT_SC_NONE && !Debounce(kbd, scanCode))
         {
             uint8_t baseCode = scanCode & 0x7F;
+            bool accepted = false;
+
             if (scanCode & (1 << 7))
             {
-                BitArray_ClearBit(&_keyState, baseCode);
-                CircularBuffer_Insert(&_scanCodeBuffer, scanCode);
+                BitArray_ClearBit(&kbd->keyState, baseCode);
+                accepted = true;
             }
-            /* Ignore key press if it has already been set */
-            else if (XTH_KBD_FWD_TYPEMATIC || !BitArray_IsSet(&_keyState, baseCode) )
+            /* Ignore key press if it has already been set, the keyboard's 
+             * own repeats are replaced by the PS/2 typematic engine */
+            else if (!BitArray_IsSet(&kbd->keyState, baseCode))
+            {
+                BitArray_SetBit(&kbd->keyState, baseCode);
+                accepted = true;
+            }
+
+            if (accepted)
             {
-                BitArray_SetBit(&_keyState, baseCode);
-                CircularBuffer_Insert(&_scanCodeBuffer, scanCode);
+                CircularBuffer_Insert(&kbd->scanCodeBuffer, scanCode);
+                CONSOLE_SEND8(CON_SRC_XTH_KBD, CON_SEV_TRACE_INFO, CON_MSG_XTH_KBD_SCAN_CODE, scanCode);
             }
         }
     }
 
     if (_scanCodeHandler != (OnScanCode)0)
     {
-        uint8_t scanCode = XthKbd_GetScanCode();
-        _scanCodeHandler(scanCode);
+        uint8_t scanCode = XthKbd_GetScanCode(instance);
+        _scanCodeHandler(instance, scanCode);
+    }
+}
+
+/* -----------------------------------------------------------------------
+ *  Folds the E0 and E1 prefixed sequences sent by enhanced keyboards
+ *  into a single extended scan code with the break bit of the sequence.
+ *   - E0 xx maps xx to its extended code, fake shifts (E0 2A, E0 36) and
+ *     unknown codes are discarded
+ *   - E1 1D 45 / E1 9D C5 map to the Pause make / break
+ *   - Unprefixed codes beyond the base codes are discarded
+ *  Returns XT_SC_NONE while a sequence is incomplete.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static uint8_t DecodePrefix(XthKbd* kbd, uint8_t scanCode)
+{
+    uint8_t baseCode = scanCode & 0x7F;
+    uint8_t breakBit = scanCode & (1 << 7);
+    XthKbdPrefix prefix = kbd->prefix;
+
+    kbd->prefix = PREFIX_NONE;
+
+    switch (prefix)
+    {
+        case PREFIX_E0:
+            baseCode = ExtendedCode(baseCode);
+            return (baseCode == XT_SC_NONE) ? XT_SC_NONE : (baseCode | breakBit);
+
+        case PREFIX_E1:
+            if (baseCode == XT_SC_CONTROL)
+            {
+                kbd->prefix = PREFIX_E1_CONTROL;
+                return XT_SC_NONE;
+            }
+            break;
+
+        case PREFIX_E1_CONTROL:
+            if (baseCode == XT_SC_NUM_LOCK)
+                return XT_SC_PAUSE | breakBit;
+            break;
+
+        default:
+            break;
+    }
+
+    if (scanCode == XT_SC_PREFIX_E0)
+    {
+        kbd->prefix = PREFIX_E0;
+        return XT_SC_NONE;
+    }
+
+    if (scanCode == XT_SC_PREFIX_E1)
+    {
+        kbd->prefix = PREFIX_E1;
+        return XT_SC_NONE;
+    }
+
+    /* XT_SC_BAT_COMPLETE is passed on as before */
+    if (baseCode > XT_SC_MAX_BASE_CODE && scanCode != XT_SC_BAT_COMPLETE)
+        return XT_SC_NONE;
+
+    return scanCode;
+}
+
+/* -----------------------------------------------------------------------
+ *  Maps the code following an E0 prefix to its extended scan code.
+ *  Returns XT_SC_NONE for fake shifts and codes without a key.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static uint8_t ExtendedCode(uint8_t baseCode)
+{
+    switch (baseCode)
+    {
+        case XT_SC_ENTER:       return XT_SC_KP_ENTER;
+        case XT_SC_CONTROL:     return XT_SC_RCONTROL;
+        case XT_SC_FWD_SLASH:   return XT_SC_KP_SLASH;
+        case XT_SC_KP_ASTERISK: return XT_SC_PRINT_SCREEN;
+        case XT_SC_ALT:         return XT_SC_RALT;
+        case XT_SC_SCROLL_LOCK: return XT_SC_BREAK;
+        case XT_SC_KP_7:        return XT_SC_HOME;
+        case XT_SC_KP_8:        return XT_SC_UP;
+        case XT_SC_KP_9:        return XT_SC_PAGE_UP;
+        case XT_SC_KP_4:        return XT_SC_LEFT;
+        case XT_SC_KP_6:        return XT_SC_RIGHT;
+        case XT_SC_KP_1:        return XT_SC_END;
+        case XT_SC_KP_2:        return XT_SC_DOWN;
+        case XT_SC_KP_3:        return XT_SC_PAGE_DOWN;
+        case XT_SC_KP_0:        return XT_SC_INSERT;
+        case XT_SC_KP_DOT:      return XT_SC_DELETE;
+        case XT_SC_LGUI_BASE:   return XT_SC_LGUI;
+        case XT_SC_RGUI_BASE:   return XT_SC_RGUI;
+        case XT_SC_APPLICATION_BASE: return XT_SC_APPLICATION;
+        default:                return XT_SC_NONE;
+    }
+}
+
+/* -----------------------------------------------------------------------
+ *  Filters key chatter. A transition of a key within XTH_KBD_DEBOUNCE_MS
+ *  of its previous transition is recorded but not passed on.
+ *   - Keys are tracked once they change the reported key state
+ *   - Repeated makes are left to the key state
+ *  Returns true if the scan code was filtered.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static bool Debounce(XthKbd* kbd, uint8_t scanCode)
+{
+#if XTH_KBD_DEBOUNCE_MS > 0
+    uint8_t baseCode = scanCode & 0x7F;
+    bool isDown = !(scanCode & (1 << 7));
+    uint16_t now = (uint16_t)SystemTick_Now();
+    XthKbdDebounce* unused = (XthKbdDebounce*)0;
+
+    for (uint8_t i = 0; i < XTH_KBD_DEBOUNCE_SLOTS; i++)
+    {
+        XthKbdDebounce* slot = &kbd->debounce[i];
+
+        if (slot->code == baseCode)
+        {
+            if ((uint16_t)(now - slot->stamp) < DEBOUNCE_TICKS)
+            {
+                if (slot->isDown != isDown)
+                {
+                    slot->isDown = isDown;
+                    slot->stamp = now;
+                    kbd->chatterCount++;
+                    CONSOLE_SEND8(CON_SRC_XTH_KBD, CON_SEV_TRACE_INFO, CON_MSG_XTH_KBD_CHATTER, scanCode);
+                    return true;
+                }
+
+                /* Repeat of the filtered state is settled by DebounceSettle */
+                return isDown != BitArray_IsSet(&kbd->keyState, baseCode);
+            }
+
+            /* Window has passed, the key is settled */
+            slot->code = XT_SC_NONE;
+        }
+
+        if (slot->code == XT_SC_NONE)
+            unused = slot;
+    }
+
+    if (unused && isDown != BitArray_IsSet(&kbd->keyState, baseCode))
+    {
+        unused->code = baseCode;
+        unused->isDown = isDown;
+        unused->stamp = now;
     }
+#else
+    (void)kbd;
+    (void)scanCode;
+#endif
+    return false;
+}
+
+/* -----------------------------------------------------------------------
+ *  Releases keys whose debounce window has passed. If the last state
+ *  received differs from the reported key state, e.g. a filtered break
+ *  ended the chatter, the state is passed on so no key is left down.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void DebounceSettle(XthKbd* kbd)
+{
+#if XTH_KBD_DEBOUNCE_MS > 0
+    uint16_t now = (uint16_t)SystemTick_Now();
+
+    for (uint8_t i = 0; i < XTH_KBD_DEBOUNCE_SLOTS; i++)
+    {
+        XthKbdDebounce* slot = &kbd->debounce[i];
+
+        if (slot->code == XT_SC_NONE || (uint16_t)(now - slot->stamp) < DEBOUNCE_TICKS)
+            continue;
+
+        if (slot->isDown != BitArray_IsSet(&kbd->keyState, slot->code))
+        {
+            /* Retry on the next task once there is room */
+            if (CircularBuffer_IsFull(&kbd->scanCodeBuffer))
+                continue;
+
+            if (slot->isDown)
+            {
+                BitArray_SetBit(&kbd->keyState, slot->code);
+                CircularBuffer_Insert(&kbd->scanCodeBuffer, slot->code);
+            }
+            else
+            {
+                BitArray_ClearBit(&kbd->keyState, slot->code);
+                CircularBuffer_Insert(&kbd->scanCodeBuffer, slot->code | (1 << 7));
+            }
+            kbd->settledCount++;
+        }
+
+        slot->code = XT_SC_NONE;
+    }
+#else
+    (void)kbd;
+#endif
+}
+
+static void DebounceClear(XthKbd* kbd)
+{
+#if XTH_KBD_DEBOUNCE_MS > 0
+    for (uint8_t i = 0; i < XTH_KBD_DEBOUNCE_SLOTS; i++)
+        kbd->debounce[i].code = XT_SC_NONE;
+#else
+    (void)kbd;
+#endif
 }
 
 void XthKbd_Reset(void)
@@ -115,24 +435,29 @@ void XthKbd_Reset(void)
     if (!_enabled)
         return;
 
-    CircularBuffer_Clear(&_scanCodeBuffer);
-    XthXcvr_SoftReset();
-    _detected = false;
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++)
+    {
+        CircularBuffer_Clear(&_kbd[instance].scanCodeBuffer);
+        XthXcvr_SoftReset(instance);
+        _kbd[instance].detected = false;
+        _kbd[instance].prefix = PREFIX_NONE;
+        DebounceClear(&_kbd[instance]);
+    }
 }
 
 
-bool XthKbd_IsScanCodeAvailable(void)
+bool XthKbd_IsScanCodeAvailable(uint8_t instance)
 {
-    return !CircularBuffer_IsEmpty(&_scanCodeBuffer);
+    return !CircularBuffer_IsEmpty(&_kbd[instance].scanCodeBuffer);
 }
 
-uint8_t XthKbd_GetScanCode(void)
+uint8_t XthKbd_GetScanCode(uint8_t instance)
 {
     uint8_t scanCode = 0x00;
 
-    if (_enabled && !CircularBuffer_IsEmpty(&_scanCodeBuffer))
+    if (_enabled && !CircularBuffer_IsEmpty(&_kbd[instance].scanCodeBuffer))
     {
-        scanCode = CircularBuffer_Remove(&_scanCodeBuffer);
+        scanCode = CircularBuffer_Remove(&_kbd[instance].scanCodeBuffer);
     }
 
     return scanCode;
@@ -20,12 +20,13 @@
 #include "xth_xcvr.h"
 
 
-typedef void (*OnScanCode)(uint8_t scanCode);
+typedef void (*OnScanCode)(uint8_t instance, uint8_t scanCode);
 
 
 /* -----------------------------------------------------------------------
  * Description:
- *  Initializes the XT host subsystem.
+ *  Initializes the XT host subsystem, one keyboard per XT transceiver 
+ *  instance numbered from 0 to XTH_XCVR_INSTANCES - 1.
  *
  * Parameters:
  *  xcvrOptions - optons for the transceiver
@@ -37,7 +38,7 @@ void XthKbd_Init(void);
 
 /* -----------------------------------------------------------------------
  * Description:
- *  Enables the XT host subsystem. 
+ *  Enables the XT host subsystem, resetting all keyboards. 
  *
  * Parameters:
  *  n/a
@@ -76,7 +77,7 @@ void XthKbd_Task(void);
 
 /* -----------------------------------------------------------------------
  * Description:
- *  Issues a reset to the XT keyboard.
+ *  Issues a reset to all XT keyboards.
  * 
  * Parameters:
  *  n/a
@@ -92,12 +93,12 @@ void XthKbd_Reset(void);
  *  Determine if a scan code has been received from the keyboard. 
  * 
  * Parameters:
- *  n/a
+ *  instance - keyboard
  * 
  * Returns: 
  *  true is a scan code is available.
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-bool XthKbd_IsScanCodeAvailable(void);
+bool XthKbd_IsScanCodeAvailable(uint8_t instance);
 
 
 /* -----------------------------------------------------------------------
@@ -105,13 +106,13 @@ bool XthKbd_IsScanCodeAvailable(void);
  *  Retrieve a scan code received from the keyboard.
  * 
  * Parameters:
- *  n/a
+ *  instance - keyboard
  * 
  * Returns: 
  *  Scan code received from the keyboard.
  *  0x00 if there was no scanCode available
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-uint8_t XthKbd_GetScanCode(void);
+uint8_t XthKbd_GetScanCode(uint8_t instance);
 
 
 /* -----------------------------------------------------------------------
@@ -7,13 +7,15 @@
  * Operational Summary:
  *  The XT clock line is connected to a pin having external interrupt
  *  functionality. The interrupt is triggered on the signal's falling edge.
- *  Each time the interrupt is triggered, the receive state is advanced.
- *  For states corresponding to data bits, the state of the data line is
- *  read and the value of the corresponding bit in the received data is 
- *  updated. When the entire frame has been received, the received scan code 
- *  is added to the receive queue. Queued scan codes are retrieved from 
- *  the receive queue using the XthXcvr_DataReceeved() and 
- *  XthXcvr_ReadReceivedData() functions.
+ *  The interrupt only captures the edge: the state of the data line and
+ *  the time elapsed since the previous edge are placed in the edge queue.
+ *  Keeping the interrupt short avoids delaying the PS/2 bus timer.
+ *  XthXcvr_Update() decodes queued edges, advancing the receive state.
+ *  For states corresponding to data bits, the captured data line state
+ *  updates the corresponding bit in the received data. When the entire 
+ *  frame has been received, the received scan code is added to the receive
+ *  queue. Queued scan codes are retrieved from the receive queue using the
+ *  XthXcvr_DataReceeved() and XthXcvr_ReadReceivedData() functions.
  * 
  * Special Error Handling:
  *  When the START bit is received an error task is scheduled.
@@ -28,15 +30,44 @@
  *  1) Keyboard is held in reset (reset low, clock low) for 20ms. Compliant
  *     keyboards will not send data until clock and/or reset is released.
  *     This should sync start of frame.
- *  2) The transceiver maintains a free running timer such that when the 
- *     counter hits 255, it rolls over to 0 (no interrupt is generated).
- *     The count of this timer is recorded and then reset on the falling 
- *     edge of the clock line. In this way the timer count indicates the 
- *     time that has elapsed since the last falling edge of the clock line.
- *     If the time is greater than a specified threshold or the overflow 
- *     flag has been set, a start of frame has been detected. This threshold 
- *     must be twice the period of the clock.
+ *  2) The transceiver maintains a free running timer. The count of this
+ *     timer is recorded on the falling edge of the clock line, the
+ *     difference from the count recorded on the previous edge is the time
+ *     elapsed since the last falling edge of the clock line. The timer
+ *     overflow interrupt counts the wraps since each instance's last edge.
+ *     If the time is greater than a specified threshold or the timer has
+ *     wrapped past the previous edge, a start of frame has been detected.
+ *     This threshold must be twice the period of the clock.
  * 
+ * Receive queue
+ *  Received scan codes are placed in a queue by XthXcvr_Update(). The clock 
+ *  line is only held low, preventing the keyboard from sending, when the
+ *  receive queue or the edge queue is full. It is released once 
+ *  XthXcvr_ReadReceivedData() has removed a scan code or XthXcvr_Update()
+ *  has emptied the edge queue. A queue size of 1 holds the clock after 
+ *  every scan code.
+ * 
+ * Protocol detection
+ *  Keyboards using 2 start bits hold DATA low during the first start bit
+ *  while keyboards using a single start bit send it high. The level of 
+ *  DATA on the first clock of the first frame after a reset selects the
+ *  variant, and the average bit period of that frame sets the start of
+ *  frame threshold. Both are then locked in until the next reset, or
+ *  until XTH_XCVR_PROTOCOL_RELOCK_ERRORS consecutive framing errors show
+ *  the lock was taken from a corrupt frame.
+ * 
+ * Reset timing
+ *  Reset durations are deadlines on the system tick polled by 
+ *  XthXcvr_Update(), the XT timer is only used for start of frame 
+ *  detection.
+ * 
+ * Instances
+ *  Up to XTH_XCVR_INSTANCES keyboards are received, each with its own
+ *  clock interrupt, pins, receive state and receive queue. The start of
+ *  frame timer and the edge queue are shared, edges are tagged with the
+ *  instance that captured them. A full edge queue holds every clock line.
+ *  The reset line, if enabled, belongs to the first instance.
+ *
  * License:
  *  Copyright (c) 2015, Engicoder
  *  All rights reserved.
@@ -46,12 +77,33 @@
 #include "common.h"
 #include "xth_xcvr_config.h"
 #include "xth_xcvr_hal.h"
+#include "system_tick.h"
 #include "xth_xcvr.h"
 #include "con_msg_xth_xcvr.h"
+#include "atomic_hal.h"
 
 #include "console.h"
 
-#define XTH_XCVR_SOF_THRESHOLD_COUNT (XTH_XCVR_SOF_THRESHOLD * XTH_XCVR_SOF_MULTIPLIER)
+#define XTH_XCVR_SOF_THRESHOLD_COUNT XTH_XCVR_US_TO_SOF_COUNT(XTH_XCVR_SOF_THRESHOLD)
+#define XTH_XCVR_GLITCH_THRESHOLD_COUNT XTH_XCVR_US_TO_SOF_COUNT(XTH_XCVR_GLITCH_THRESHOLD)
+
+/* Captured edge, the timer count since the previous edge with flags for
+ * the data line state, a timer overflow and the capturing instance */
+#define EDGE_DATA_HIGH  (1 << 15)
+#define EDGE_OVERFLOW   (1 << 14)
+#define EDGE_INSTANCE   (1 << 13)
+#define EDGE_COUNT_MASK 0x1FFF
+
+/* Clock edges in a frame with 2 start bits, one less with 1 start bit */
+#define FRAME_EDGES 10
+
+/* Free edge queue entries needed to let every instance send one more 
+ * frame, a clock is held at the end of a frame once fewer are free */
+#define EDGE_QUEUE_RESERVE (XTH_XCVR_INSTANCES * FRAME_EDGES)
+
+#if XTH_XCVR_EDGE_QUEUE_SIZE <= EDGE_QUEUE_RESERVE
+    #error "XTH_XCVR_EDGE_QUEUE_SIZE must hold more than a frame from every instance."
+#endif
 
 #define XTH_XCVR_STATUS_RECV_MASK (XTH_XCVR_STATUS_RECV_BUFFER_FULL | \
                                    XTH_XCVR_STATUS_RECV_OVERFLOW )
@@ -69,101 +121,267 @@ typedef enum {
     XCVR_STATE_IDLE,
 } XcvrState;
 
-static volatile uint8_t _receiveRegister;
-static volatile uint8_t _receiveBuffer;
-volatile XthXcvrStatus _xthXcvrStatus = 0;
-static ReceiveState _receiveState = IDLE;
-static XcvrState _xcvrState = XCVR_STATE_DISABLED;
-volatile uint16_t _timerCount = 0;
+/* State of a single keyboard */
+typedef struct _XthXcvrInstance
+{
+    XcvrState xcvrState;
+    ReceiveState receiveState;
+    uint8_t receiveRegister;
+    uint8_t recvQueue[XTH_XCVR_RECV_QUEUE_SIZE];
+    uint8_t recvQueueIn;
+    uint8_t recvQueueOut;
+    volatile bool clockHeld;
+
+    /* Timer count at the last edge and the timer wraps since, saturates
+     * at 2 */
+    uint16_t lastEdgeCount;
+    volatile uint8_t timerWraps;
+    uint8_t frameEdges;     /* Edges captured in the current frame */
+
+    SystemTick resetDeadline;
+    bool resetLineHeld;
+
+    /* Protocol detection - start bit variant and clock period are learned
+     * from the first frame received after a reset */
+    bool protocolLocked;
+    bool oneStartBit;
+    uint16_t sofThresholdCount;
+    uint16_t clockPeriod;
+    uint16_t periodSum;
+    uint8_t periodCount;
+    uint8_t frameErrors;    /* Consecutive framing errors */
+
+    XthXcvrStats stats;
+} XthXcvrInstance;
+
+static XthXcvrInstance _xcvr[XTH_XCVR_INSTANCES];
+static volatile uint16_t _edgeQueue[XTH_XCVR_EDGE_QUEUE_SIZE];
+static volatile uint8_t _edgeQueueIn;
+static uint8_t _edgeQueueOut;
+volatile XthXcvrStatus _xthXcvrStatus[XTH_XCVR_INSTANCES];
+
+static inline void StatusClear(uint8_t instance, XthXcvrStatus status)
+{
+    _xthXcvrStatus[instance] &= ~status;
+}
+
+static inline void StatusReset(uint8_t instance)
+{
+	_xthXcvrStatus[instance] = 0;
+}
+
+static inline void StatusResetRecv(uint8_t instance)
+{
+	_xthXcvrStatus[instance] &= ~XTH_XCVR_STATUS_RECV_MASK;
+}
+
+static inline void StatusSet(uint8_t instance, XthXcvrStatus status)
+{
+    _xthXcvrStatus[instance] |= status;
+}
+
+static inline uint8_t RecvQueueCount(XthXcvrInstance* xcvr)
+{
+    return (uint8_t)(xcvr->recvQueueIn - xcvr->recvQueueOut);
+}
+
+static inline void RecvQueueClear(XthXcvrInstance* xcvr)
+{
+    xcvr->recvQueueIn = 0;
+    xcvr->recvQueueOut = 0;
+    xcvr->clockHeld = false;
+}
+
+static inline uint8_t EdgeQueueCount(void)
+{
+    return (uint8_t)(_edgeQueueIn - _edgeQueueOut);
+}
+
+/* True if every instance can send another frame */
+static inline bool EdgeQueueHasReserve(void)
+{
+    return XTH_XCVR_EDGE_QUEUE_SIZE - EdgeQueueCount() >= EDGE_QUEUE_RESERVE;
+}
 
-static inline void StatusClear(XthXcvrStatus status)
+/* Hold the clock low to stop the keyboard sending */
+static inline void ClockHold(uint8_t instance)
 {
-    _xthXcvrStatus &= ~status;
+    XthXcvrHal_ClockHoldLow(instance);
+    _xcvr[instance].clockHeld = true;
 }
 
-static inline void StatusReset(void)
+static inline void StatsIncrement(uint16_t* count)
 {
-	_xthXcvrStatus = 0;
+    if (XTH_XCVR_STATS_ENABLE && *count < UINT16_MAX)
+        (*count)++;
 }
 
-static inline void StatusResetRecv(void)
+static inline void StatsBitPeriod(XthXcvrInstance* xcvr, uint16_t period)
+{
+    if (XTH_XCVR_STATS_ENABLE) {
+        if (period < xcvr->stats.bitPeriodMin)
+            xcvr->stats.bitPeriodMin = period;
+        if (period > xcvr->stats.bitPeriodMax)
+            xcvr->stats.bitPeriodMax = period;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ *  Restart protocol detection, or apply the configured protocol if 
+ *  detection is disabled.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void ProtocolReset(XthXcvrInstance* xcvr)
+{
+    xcvr->protocolLocked = !XTH_XCVR_PROTOCOL_DETECT;
+    xcvr->oneStartBit = XTH_XCVR_1_START_BIT;
+    xcvr->sofThresholdCount = XTH_XCVR_SOF_THRESHOLD_COUNT;
+    xcvr->clockPeriod = 0;
+    xcvr->frameErrors = 0;
+}
+
+/* ------------------------------------------------------------------------
+ *  Count a framing error, a bad start bit or a frame cut short by a 
+ *  start of frame
+ *   - Repeated errors restart protocol detection, the detected start bits
+ *     or clock period are likely wrong
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void FramingError(uint8_t instance)
 {
-	_xthXcvrStatus &= ~XTH_XCVR_STATUS_RECV_MASK;
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+
+    if (!XTH_XCVR_PROTOCOL_DETECT || !xcvr->protocolLocked)
+        return;
+
+    if (++xcvr->frameErrors < XTH_XCVR_PROTOCOL_RELOCK_ERRORS)
+        return;
+
+    ProtocolReset(xcvr);
+    CONSOLE_SEND8(CON_SRC_XTH_XCVR, CON_SEV_TRACE_EVENT, CON_MSG_XTH_XCVR_PROTOCOL_RELOCK, instance);
 }
 
-static inline void StatusSet(XthXcvrStatus status)
+/* ------------------------------------------------------------------------
+ *  Lock in the detected protocol once a complete frame has been received
+ *   - Nominal clock period is the average bit period of the frame
+ *   - Start of frame threshold is twice the clock period
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void ProtocolLock(XthXcvrInstance* xcvr)
 {
-    _xthXcvrStatus |= status;
+    if (xcvr->periodCount > 0) {
+        xcvr->clockPeriod = xcvr->periodSum / xcvr->periodCount;
+        xcvr->sofThresholdCount = xcvr->clockPeriod << 1;
+    }
+    xcvr->protocolLocked = true;
 }
 
 /* ------------------------------------------------------------------------
- *  Initialize XT transceiver
+ *  Initialize XT transceivers
  *   - Clear error code
- *   - Initialize XT clock and data lines
+ *   - Initialize XT clock and data lines of each instance
  *   - Initialize reset line if enabled
  *   - Set inital state and status 
+ *   - Start the shared start of frame timer
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void XthXcvr_Init(void)
 {
-    /* Initialize the data bus */
-    XthXcvrHal_ClockInit();
-    XthXcvrHal_DataInit();    
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++) {
+        XthXcvrInstance* xcvr = &_xcvr[instance];
+
+        /* Initialize the data bus */
+        XthXcvrHal_ClockInit(instance);
+        XthXcvrHal_DataInit(instance);
+
+        xcvr->receiveState = IDLE;
+        xcvr->xcvrState = XCVR_STATE_DISABLED;
+
+        StatusReset(instance);
+        RecvQueueClear(xcvr);
+        XthXcvr_ResetStats(instance);
+        ProtocolReset(xcvr);
+    }
 
     if (XTH_XCVR_RESET_LINE_ENABLE) {
         XthXcvrHal_ResetInit();
     }
 
-    _receiveState = IDLE;
-    _xcvrState = XCVR_STATE_DISABLED;
+    _edgeQueueIn = 0;
+    _edgeQueueOut = 0;
 
-    StatusReset();
+    XthXcvrHal_TimerSofStart();
 }
 
 
 /* ------------------------------------------------------------------------
  *  Read received data
- *   - Copy the contents of the receive buffer. 
- *   - Reset RECV status and clear start frame timer count.
- *   - Release the clock line to allow the keyboard to send more data
+ *   - Remove the oldest scan code from the receive queue. 
+ *   - Reset RECV status once the queue is empty.
+ *   - Release the clock line if it was held because the queue was full,
+ *     unless the edge queue is still short of a frame per instance
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-uint8_t XthXcvr_ReadReceivedData(void)
+uint8_t XthXcvr_ReadReceivedData(uint8_t instance)
 {
-    uint8_t data = _receiveBuffer;
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+    uint8_t data = XT_SC_NONE;
+    bool received = false;
+
+    ATOMIC() {
+        if (RecvQueueCount(xcvr) > 0) {
+            data = xcvr->recvQueue[xcvr->recvQueueOut & (XTH_XCVR_RECV_QUEUE_SIZE - 1)];
+            xcvr->recvQueueOut++;
+            received = true;
+
+            if (RecvQueueCount(xcvr) == 0) {
+                StatusResetRecv(instance);
+            }
 
-    if (XthXcvr_StatusIsSet(XTH_XCVR_STATUS_RECV_BUFFER_FULL)) {
-        StatusResetRecv();
+            StatusSet(instance, XTH_XCVR_STATUS_KBD_DETECTED);
 
-        if (!XthXcvr_StatusIsSet(XTH_XCVR_STATUS_KBD_DETECTED)) {
-            StatusSet(XTH_XCVR_STATUS_KBD_DETECTED);
+            if (xcvr->clockHeld && EdgeQueueHasReserve()) {
+                xcvr->clockHeld = false;
+                XthXcvrHal_ClockRelease(instance);
+            }
         }
+    }
 
-        XthXcvrHal_ClockRelease();
-
+    if (received) {
         CONSOLE_SEND8(CON_SRC_XTH_XCVR, CON_SEV_TRACE_EVENT, CON_MSG_XTH_XCVR_RECV_SCODE, data);
     }
 
     return data;
 }
 
+/* ------------------------------------------------------------------------
+ *  Clear the receive overflow status
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_ClearOverflow(uint8_t instance)
+{
+    ATOMIC() {
+        StatusClear(instance, XTH_XCVR_STATUS_RECV_OVERFLOW);
+    }
+}
+
 /* ------------------------------------------------------------------------
  *  Initiates a soft reset of the keyboard
  *   - Hold keyboard in reset for 20ms by holding clock and reset low
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_SoftReset(void)
+void XthXcvr_SoftReset(uint8_t instance)
 {
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+
     if (XTH_XCVR_SOFT_RESET_ENABLE) {
-        XthXcvrHal_DisableClockInterrupt();
-        XthXcvrHal_TimerStop();    
+        XthXcvrHal_DisableClockInterrupt(instance);
 
-        StatusReset();
-        _xcvrState = XCVR_STATE_SOFT_RESET;
+        ATOMIC() {
+            StatusReset(instance);
+            RecvQueueClear(xcvr);
+            xcvr->xcvrState = XCVR_STATE_SOFT_RESET;
+        }
+        ProtocolReset(xcvr);
 
-        XthXcvrHal_ClockHoldLow();
+        XthXcvrHal_ClockHoldLow(instance);
 
         CONSOLE_SEND0(CON_SRC_XTH_XCVR, CON_SEV_TRACE_EVENT, CON_MSG_XTH_XCVR_SOFT_RESET);
 
-        _timerCount = 0;
-        XthXcvrHal_TimerResetStart();
+        xcvr->resetDeadline = SystemTick_Deadline(SYSTEM_TICK_MS_TO_TICKS(XTH_XCVR_SOFT_RESET_DURATION));
     }
 }
 
@@ -171,146 +389,242 @@ void XthXcvr_SoftReset(void)
 /* ------------------------------------------------------------------------
  *  Handles the POR reset of the keyboard
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_PowerOnReset(void)
+void XthXcvr_PowerOnReset(uint8_t instance)
 {
-    XthXcvrHal_DisableClockInterrupt();
-    XthXcvrHal_TimerStop();    
-    XthXcvrHal_ClockRelease();
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+
+    XthXcvrHal_DisableClockInterrupt(instance);
 
-    _xcvrState = XCVR_STATE_POR;
+    ATOMIC() {
+        xcvr->xcvrState = XCVR_STATE_POR;
+        RecvQueueClear(xcvr);
+        XthXcvrHal_ClockRelease(instance);
+    }
+    ProtocolReset(xcvr);
 
-    if (XTH_XCVR_RESET_LINE_ENABLE)
+    if (XTH_XCVR_RESET_LINE_ENABLE && instance == 0)
         XthXcvrHal_ResetHoldLow();
+    xcvr->resetLineHeld = true;
 
     CONSOLE_SEND0(CON_SRC_XTH_XCVR, CON_SEV_TRACE_EVENT, CON_MSG_XTH_XCVR_HARD_RESET);
 
-    _timerCount = 0;
-    XthXcvrHal_TimerResetStart();
+    xcvr->resetDeadline = SystemTick_Deadline(SYSTEM_TICK_MS_TO_TICKS(XTH_XCVR_HARD_RESET_DURATION));
 }
 
 /* ------------------------------------------------------------------------
- *  Initiates execution of the XT host subsystem
+ *  Initiates execution of an XT transceiver instance
  *   - Set initial state
  *   - Issue reset to keyboard
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_Enable(void)
+void XthXcvr_Enable(uint8_t instance)
 {
-    _receiveState = IDLE;
-    StatusReset();
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+
+    xcvr->receiveState = IDLE;
+    StatusReset(instance);
+    RecvQueueClear(xcvr);
 
     if (XTH_XCVR_POR_ON_ENABLE) {
-        XthXcvr_PowerOnReset();
+        XthXcvr_PowerOnReset(instance);
     } else {
-        XthXcvrHal_EnableClockInterrupt();
-        _timerCount = 0;
-        XthXcvrHal_TimerSofStart();
-        _xcvrState = XCVR_STATE_IDLE;        
+        ATOMIC() {
+            xcvr->timerWraps = 2;
+            xcvr->xcvrState = XCVR_STATE_IDLE;
+        }
+        XthXcvrHal_EnableClockInterrupt(instance);
     }
 }
 
 /* ------------------------------------------------------------------------
- *  Halts execution of the XT host subsystem
+ *  Halts execution of an XT transceiver instance
+ *   - The shared start of frame timer keeps running
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_Disable(uint8_t instance)
+{
+    XthXcvrHal_DisableClockInterrupt(instance);
+
+    ATOMIC() {
+        _xcvr[instance].xcvrState = XCVR_STATE_DISABLED;
+    }
+}
 
+/* ------------------------------------------------------------------------
+ *  Number of start bits used by the keyboard, 0 if not yet detected
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_Disable(void)
+uint8_t XthXcvr_StartBits(uint8_t instance)
 {
-    XthXcvrHal_DisableClockInterrupt();
-    XthXcvrHal_TimerStop();
+    if (!_xcvr[instance].protocolLocked)
+        return 0;
+
+    return _xcvr[instance].oneStartBit ? 1 : 2;
 }
 
 /* ------------------------------------------------------------------------
- *  Timeout timer interrupt service routing
- *
- *  Invoked when the timeout timer interval has expired.
+ *  Nominal clock period in microseconds, 0 if not yet detected
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+uint16_t XthXcvr_ClockPeriod(uint8_t instance)
+{
+    return XTH_XCVR_SOF_COUNT_TO_US(_xcvr[instance].clockPeriod);
+}
+
+/* ------------------------------------------------------------------------
+ *  Copy the receive statistics
+ *   - Bit periods are converted from timer counts to microseconds
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_GetStats(uint8_t instance, XthXcvrStats* stats)
+{
+    ATOMIC() {
+        *stats = _xcvr[instance].stats;
+    }
+
+    if (stats->bitPeriodMin > stats->bitPeriodMax)
+        stats->bitPeriodMin = 0;
+
+    stats->bitPeriodMin = XTH_XCVR_SOF_COUNT_TO_US(stats->bitPeriodMin);
+    stats->bitPeriodMax = XTH_XCVR_SOF_COUNT_TO_US(stats->bitPeriodMax);
+}
+
+/* ------------------------------------------------------------------------
+ *  Clear the receive statistics
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-XTH_XCVR_RESET_TIMEOUT_ISR()
+void XthXcvr_ResetStats(uint8_t instance)
 {
-    _timerCount++;
-    switch (_xcvrState)
+    ATOMIC_RESTORE() {
+        _xcvr[instance].stats = (XthXcvrStats){ .bitPeriodMin = UINT16_MAX };
+    }
+}
+
+/* ------------------------------------------------------------------------
+ *  Send the receive statistics to the console
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_ReportStats(uint8_t instance)
+{
+#ifdef USE_CONSOLE
+    XthXcvrStats stats;
+
+    if (!XTH_XCVR_STATS_ENABLE)
+        return;
+
+    XthXcvr_GetStats(instance, &stats);
+
+    CONSOLE_SEND1616(CON_SRC_XTH_XCVR, CON_SEV_TRACE_INFO, CON_MSG_XTH_XCVR_STATS_PERIOD, stats.bitPeriodMin, stats.bitPeriodMax);
+    CONSOLE_SEND1616(CON_SRC_XTH_XCVR, CON_SEV_TRACE_INFO, CON_MSG_XTH_XCVR_STATS_FRAME, stats.sofResyncs, stats.glitches);
+    CONSOLE_SEND1616(CON_SRC_XTH_XCVR, CON_SEV_TRACE_INFO, CON_MSG_XTH_XCVR_STATS_RECV, stats.overflows, stats.kbdDetects);
+#else
+    (void)instance;
+#endif
+}
+
+/* ------------------------------------------------------------------------
+ *  Advance a keyboard reset once its current deadline has passed
+ *   - POR: release the reset line after the hard reset duration, then 
+ *     wait for clock and data to go high before the soft reset
+ *   - SOFT_RESET: release the clock and start receiving
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void ResetUpdate(uint8_t instance)
+{
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+
+    if (!SystemTick_DeadlinePassed(xcvr->resetDeadline))
+        return;
+
+    switch (xcvr->xcvrState)
     {
         case XCVR_STATE_SOFT_RESET:
         {
-            if (_timerCount >= XTH_XCVR_SOFT_RESET_DURATION) {
-                XthXcvrHal_TimerStop();
-                XthXcvrHal_ClockRelease();
-
-                XthXcvrHal_EnableClockInterrupt();
-                _timerCount = 0;
-                XthXcvrHal_TimerSofStart();
-                _xcvrState = XCVR_STATE_IDLE;
-                StatusSet(XTH_XCVR_STATUS_READY);
+            XthXcvrHal_ClockRelease(instance);
+
+            /* The first edge after the reset starts a frame */
+            ATOMIC() {
+                xcvr->receiveState = IDLE;
+                xcvr->timerWraps = 2;
+                xcvr->xcvrState = XCVR_STATE_IDLE;
+                StatusSet(instance, XTH_XCVR_STATUS_READY);
             }
+            XthXcvrHal_EnableClockInterrupt(instance);
         }
         break;
 
         case XCVR_STATE_POR:
         {
-            if (_timerCount == XTH_XCVR_HARD_RESET_DURATION) {
-                if (XTH_XCVR_RESET_LINE_ENABLE) {
+            if (xcvr->resetLineHeld) {
+                if (XTH_XCVR_RESET_LINE_ENABLE && instance == 0) {
                     XthXcvrHal_ResetRelease(XTH_XCVR_RESET_LINE_HAS_PULLUP);
-                }    
-            } else if (_timerCount >= XTH_XCVR_POR_DURATION &&
-                       XthXcvrHal_ClockIsHigh() &&
-                       XthXcvrHal_DataIsHigh() ) {
-                if (XTH_XCVR_SOFT_RESET_ENABLE){
-                   XthXcvrHal_ClockHoldLow();
-                    _timerCount = 0;
-                } else {
-                    _timerCount = XTH_XCVR_SOFT_RESET_DURATION;
                 }
-                _xcvrState = XCVR_STATE_SOFT_RESET;
+                xcvr->resetLineHeld = false;
+                xcvr->resetDeadline += SYSTEM_TICK_MS_TO_TICKS(XTH_XCVR_POR_DURATION - XTH_XCVR_HARD_RESET_DURATION);
+            } else if (XthXcvrHal_ClockIsHigh(instance) && XthXcvrHal_DataIsHigh(instance)) {
+                if (XTH_XCVR_SOFT_RESET_ENABLE) {
+                    XthXcvrHal_ClockHoldLow(instance);
+                    xcvr->resetDeadline = SystemTick_Deadline(SYSTEM_TICK_MS_TO_TICKS(XTH_XCVR_SOFT_RESET_DURATION));
+                }
+                xcvr->xcvrState = XCVR_STATE_SOFT_RESET;
             }
         }
         break;
 
         default:
-        {
-            // Error
-        }
         break;
-
     }
-
-
-    return;
 }
 
 /* ------------------------------------------------------------------------
- *  XT Clock line interrupt service routine
+ *  Decode a captured clock edge
  *
- *  Triggered on the rising edge of the XT clock line. Manages reception of
- *  a single scan code frame from the XT device. 
+ *  Manages reception of a single scan code frame from the XT device. 
+ *  Called by XthXcvr_Update() for each edge captured by the clock ISRs.
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-XTH_XCVR_CLOCK_ISR()
+static void DecodeEdge(uint16_t edge)
 {
-    bool dataLineHigh = XthXcvrHal_DataIsHigh();
-
-    bool timerOverflow = XthXcvrHal_TimerSofOverflow();
-    uint16_t timerCount = XthXcvrHal_TimerSofCount();
-    XthXcvrHal_TimerSofCountReset();
-
-    if ((timerCount > XTH_XCVR_SOF_THRESHOLD_COUNT) || timerOverflow) {
-        StatusResetRecv();
-        _receiveState = IDLE;
+    uint8_t instance = (edge & EDGE_INSTANCE) ? 1 : 0;
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+    bool dataLineHigh = (edge & EDGE_DATA_HIGH) != 0;
+    bool timerOverflow = (edge & EDGE_OVERFLOW) != 0;
+    uint16_t timerCount = edge & EDGE_COUNT_MASK;
+
+    /* Edges captured before a reset started are discarded */
+    if (xcvr->xcvrState != XCVR_STATE_IDLE)
+        return;
+
+    if ((timerCount > xcvr->sofThresholdCount) || timerOverflow) {
+        if (xcvr->receiveState != IDLE) {
+            StatsIncrement(&xcvr->stats.sofResyncs);
+            FramingError(instance);
+        }
+        xcvr->receiveState = IDLE;
+    } else if (xcvr->receiveState != IDLE) {
+        StatsBitPeriod(xcvr, timerCount);
+        if (!xcvr->protocolLocked) {
+            xcvr->periodSum += timerCount;
+            xcvr->periodCount++;
+        }
     }
 
-    _receiveState++;
+    xcvr->receiveState++;
 
-    switch (_receiveState) 
+    switch (xcvr->receiveState)
     {
         case IDLE: /* Should never happen */
             break;
         case START1:
-            _receiveRegister = 0;
-            if (XTH_XCVR_1_START_BIT) {
-                _receiveState = START2;
+            xcvr->receiveRegister = 0;
+            if (!xcvr->protocolLocked) {
+                /* Keyboards using 2 start bits hold DATA low for the first
+                 * start bit, those using 1 start bit send it high. */
+                xcvr->oneStartBit = dataLineHigh;
+                xcvr->periodSum = 0;
+                xcvr->periodCount = 0;
+            }
+            if (xcvr->oneStartBit) {
+                xcvr->receiveState = START2;
                 /* !!! FALLTHROUGH to START2 case !!! */
             } else
                 break;
             
         case START2:
             if (!dataLineHigh) {
-                _receiveState = IDLE;
+                xcvr->receiveState = IDLE;
+                FramingError(instance);
             }
             break;
 
@@ -325,39 +639,192 @@ XTH_XCVR_CLOCK_ISR()
             
             /* Record the data line state 
              * in the next bit of the scan code */
-            _receiveRegister = _receiveRegister >> 1;
+            xcvr->receiveRegister = xcvr->receiveRegister >> 1;
             if (dataLineHigh) {
-                _receiveRegister |= (1 << 7);
+                xcvr->receiveRegister |= (1 << 7);
             }
 
-            if (_receiveState == DATA7) {
-                /* Hold clock low until host can record data and update status
-                 * in XthXcvr_ReadReceivedData() */
-                XthXcvrHal_ClockHoldLow();
-
-                if (_receiveRegister == 0xAA &&
-                    !XthXcvr_StatusIsSet(XTH_XCVR_STATUS_KBD_DETECTED)) {
-                    StatusSet(XTH_XCVR_STATUS_KBD_DETECTED);
-                    XthXcvrHal_ClockRelease();
-                } else if (XthXcvr_StatusIsSet(XTH_XCVR_STATUS_RECV_BUFFER_FULL)) {
-                    /* If the receive buffer is full, set OVERFLOW status
-                    * and discard data */
-                    StatusSet(XTH_XCVR_STATUS_RECV_OVERFLOW);
+            if (xcvr->receiveState == DATA7) {
+                if (xcvr->receiveRegister == 0xAA &&
+                    !XthXcvr_StatusIsSet(instance, XTH_XCVR_STATUS_KBD_DETECTED)) {
+                    ATOMIC() {
+                        StatusSet(instance, XTH_XCVR_STATUS_KBD_DETECTED);
+                    }
+                    StatsIncrement(&xcvr->stats.kbdDetects);
+                } else if (RecvQueueCount(xcvr) == XTH_XCVR_RECV_QUEUE_SIZE) {
+                    /* If the receive queue is full, set OVERFLOW status
+                    * and discard data. The ISR also counts overflows. */
+                    ATOMIC() {
+                        StatusSet(instance, XTH_XCVR_STATUS_RECV_OVERFLOW);
+                        StatsIncrement(&xcvr->stats.overflows);
+                    }
                 } else {
-                    /* Copy received data into receive buffer and set 
+                    /* Add received data to the receive queue and set 
                     * BUFFER_FULL status. */
-                    _receiveBuffer = _receiveRegister;
+                    xcvr->recvQueue[xcvr->recvQueueIn & (XTH_XCVR_RECV_QUEUE_SIZE - 1)] = xcvr->receiveRegister;
+                    xcvr->recvQueueIn++;
                     
-                    StatusSet(XTH_XCVR_STATUS_RECV_BUFFER_FULL);
+                    ATOMIC() {
+                        StatusSet(instance, XTH_XCVR_STATUS_RECV_BUFFER_FULL);
+                    }
+                }
+
+                /* Hold clock low while the queue is full until the host
+                 * reads data in XthXcvr_ReadReceivedData() */
+                if (RecvQueueCount(xcvr) == XTH_XCVR_RECV_QUEUE_SIZE) {
+                    ATOMIC() {
+                        ClockHold(instance);
+                    }
                 }
 
+                if (!xcvr->protocolLocked) {
+                    ProtocolLock(xcvr);
+                }
+                xcvr->frameErrors = 0;
+
                 /* Reset the frame state to IDLE */
-                _receiveState = IDLE;
+                xcvr->receiveState = IDLE;
 
             }
             break;
     }
+}
+
+/* ------------------------------------------------------------------------
+ *  Advance any keyboard reset in progress and decode captured clock edges
+ *   - Release clock lines held for the edge queue once the receive queue
+ *     has room
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_Update(void)
+{
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++) {
+        XcvrState state = _xcvr[instance].xcvrState;
+        if (state == XCVR_STATE_POR || state == XCVR_STATE_SOFT_RESET)
+            ResetUpdate(instance);
+    }
+
+    while (EdgeQueueCount() > 0) {
+        DecodeEdge(_edgeQueue[_edgeQueueOut & (XTH_XCVR_EDGE_QUEUE_SIZE - 1)]);
+        _edgeQueueOut++;
+    }
+
+    ATOMIC() {
+        for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++) {
+            XthXcvrInstance* xcvr = &_xcvr[instance];
+            if (xcvr->clockHeld && RecvQueueCount(xcvr) < XTH_XCVR_RECV_QUEUE_SIZE &&
+                EdgeQueueHasReserve()) {
+                xcvr->clockHeld = false;
+                XthXcvrHal_ClockRelease(instance);
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------
+ *  Count a start of frame timer wrap for every instance
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void TimerWrapped(void)
+{
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++) {
+        if (_xcvr[instance].timerWraps < 2)
+            _xcvr[instance].timerWraps++;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ *  Capture a falling edge of an instance's clock line
+ *
+ *  Captures the data line state and the time since the instance's
+ *  previous edge for XthXcvr_Update(). Edges closer than
+ *  XTH_XCVR_GLITCH_THRESHOLD to the previous edge are ignored; the time
+ *  is still measured from the last valid edge. Inlined into each clock
+ *  ISR with a constant instance.
+ *
+ *  The clock is held low only between frames, at the last edge of a
+ *  frame once the queue can no longer take a frame from every instance.
+ *  Frames are counted from the edges, a long gap restarts the count. An
+ *  edge arriving at a full queue is discarded with its frame.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline __attribute__((always_inline)) void CaptureEdge(uint8_t instance)
+{
+    XthXcvrInstance* xcvr = &_xcvr[instance];
+    bool dataLineHigh = XthXcvrHal_DataIsHigh(instance);
+    uint16_t count = XthXcvrHal_TimerSofCount();
+
+    /* The overflow ISR cannot run until this one returns, count the wrap
+     * now. The count is read again in case it wrapped after the first
+     * read. */
+    if (XthXcvrHal_TimerSofOverflow()) {
+        count = XthXcvrHal_TimerSofCount();
+        XthXcvrHal_TimerSofClearOverflow();
+        TimerWrapped();
+    }
+
+    uint8_t wraps = xcvr->timerWraps;
+    bool timerOverflow = (wraps > 1) || (wraps == 1 && count >= xcvr->lastEdgeCount);
+    uint16_t edge = (count - xcvr->lastEdgeCount) & XTH_XCVR_SOF_TIMER_MAX;
 
-    return;
+#if XTH_XCVR_GLITCH_THRESHOLD > 0
+    if (!timerOverflow && edge < XTH_XCVR_GLITCH_THRESHOLD_COUNT) {
+        StatsIncrement(&xcvr->stats.glitches);
+        return;
+    }
+#endif
+
+    xcvr->lastEdgeCount = count;
+    xcvr->timerWraps = 0;
+
+    if (timerOverflow || edge > XTH_XCVR_SOF_THRESHOLD_COUNT)
+        xcvr->frameEdges = 0;
+
+    if (timerOverflow || edge > EDGE_COUNT_MASK)
+        edge = EDGE_OVERFLOW;
+    if (dataLineHigh)
+        edge |= EDGE_DATA_HIGH;
+    if (instance)
+        edge |= EDGE_INSTANCE;
+
+    /* Until the protocol is locked frames are assumed to have 2 start 
+     * bits, a shorter frame is ended by the gap before the next */
+    uint8_t frameLength = (xcvr->protocolLocked && xcvr->oneStartBit) ? FRAME_EDGES - 1 : FRAME_EDGES;
+    bool frameEnd = (++xcvr->frameEdges >= frameLength);
+    if (frameEnd)
+        xcvr->frameEdges = 0;
+
+    if (EdgeQueueCount() < XTH_XCVR_EDGE_QUEUE_SIZE) {
+        uint8_t in = _edgeQueueIn;
+        _edgeQueue[in & (XTH_XCVR_EDGE_QUEUE_SIZE - 1)] = edge;
+        _edgeQueueIn = ++in;
+    } else {
+        StatsIncrement(&xcvr->stats.overflows);
+    }
+
+    /* Stop the keyboard until XthXcvr_Update() catches up */
+    if (frameEnd && !EdgeQueueHasReserve() && xcvr->xcvrState == XCVR_STATE_IDLE)
+        ClockHold(instance);
 }
 
+/* ------------------------------------------------------------------------
+ *  XT Clock line interrupt service routines
+ *
+ *  Triggered on the falling edge of each instance's XT clock line.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+XTH_XCVR_CLOCK_ISR()
+{
+    CaptureEdge(0);
+}
+
+#if XTH_XCVR_INSTANCES > 1
+XTH_XCVR_CLOCK2_ISR()
+{
+    CaptureEdge(1);
+}
+#endif
+
+/* ------------------------------------------------------------------------
+ *  Start of frame timer overflow interrupt service routine
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+XTH_XCVR_TIMER_OVERFLOW_ISR()
+{
+    TimerWrapped();
+}
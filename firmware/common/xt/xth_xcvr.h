@@ -39,41 +39,55 @@ typedef enum
     XTH_XCVR_STATUS_RECV_OVERFLOW          = (1 << 4),
 }XthXcvrStatus;
 
-extern volatile XthXcvrStatus _xthXcvrStatus;
+/* Receive statistics recorded by the clock ISR. Bit periods are in 
+ * microseconds when read using XthXcvr_GetStats() */
+typedef struct _XthXcvrStats
+{
+    uint16_t bitPeriodMin;
+    uint16_t bitPeriodMax;
+    uint16_t sofResyncs;    /* Frames restarted by start of frame detection */
+    uint16_t glitches;      /* Clock edges rejected by the glitch filter */
+    uint16_t overflows;     /* Frames discarded due to a full buffer */
+    uint16_t kbdDetects;    /* 0xAA self-test results detected */
+} XthXcvrStats;
+
+/* Status of each instance, indexed by instance */
+extern volatile XthXcvrStatus _xthXcvrStatus[];
 
-static inline XthXcvrStatus XthXcvr_Status(void)
+static inline XthXcvrStatus XthXcvr_Status(uint8_t instance)
 {
-    return _xthXcvrStatus;
+    return _xthXcvrStatus[instance];
 }
 
-static inline bool XthXcvr_StatusIsSet(XthXcvrStatus status)
+static inline bool XthXcvr_StatusIsSet(uint8_t instance, XthXcvrStatus status)
 {
-    return (_xthXcvrStatus & status);
+    return (_xthXcvrStatus[instance] & status);
 }
 
-static inline bool XthXcvr_StatusDataReceived(void)
+static inline bool XthXcvr_StatusDataReceived(uint8_t instance)
 {
-    return XthXcvr_StatusIsSet(XTH_XCVR_STATUS_RECV_BUFFER_FULL);
+    return XthXcvr_StatusIsSet(instance, XTH_XCVR_STATUS_RECV_BUFFER_FULL);
 }
 
-static inline bool XthXcvr_StatusReady(void)
+static inline bool XthXcvr_StatusReady(uint8_t instance)
 {
-    return XthXcvr_StatusIsSet(XTH_XCVR_STATUS_READY);
+    return XthXcvr_StatusIsSet(instance, XTH_XCVR_STATUS_READY);
 }
 
-static inline bool XthXcvr_StatusKeyboardDetected(void)
+static inline bool XthXcvr_StatusKeyboardDetected(uint8_t instance)
 {
-    return XthXcvr_StatusIsSet(XTH_XCVR_STATUS_KBD_DETECTED);
+    return XthXcvr_StatusIsSet(instance, XTH_XCVR_STATUS_KBD_DETECTED);
 }
 
-static inline bool XthXcvr_StatusIsOverflow(void)
+static inline bool XthXcvr_StatusIsOverflow(uint8_t instance)
 {
-	return XthXcvr_StatusIsSet(XTH_XCVR_STATUS_RECV_OVERFLOW);  
+	return XthXcvr_StatusIsSet(instance, XTH_XCVR_STATUS_RECV_OVERFLOW);  
 }
 
 /* -----------------------------------------------------------------------
  * Description:
- *  Initialize the XT host subsystem.
+ *  Initialize the XT host subsystem, all transceiver instances and the
+ *  shared start of frame timer.
  *
  * Parameters:
  *  n/a
@@ -90,12 +104,12 @@ void XthXcvr_Init(void);
  *  keyboard.
  *
  * Parameters:
- *  n/a
+ *  instance - transceiver instance
  * 
  * Returns: 
  *  n/a
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_Enable(void);
+void XthXcvr_Enable(uint8_t instance);
 
 /* -----------------------------------------------------------------------
  * Description:
@@ -103,16 +117,19 @@ void XthXcvr_Enable(void);
  *  no longer detect scan codes from the keyboard.
  *
  * Parameters:
- *  n/a
+ *  instance - transceiver instance
  * 
  * Returns: 
  *  n/a
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_Disable(void);
+void XthXcvr_Disable(uint8_t instance);
 
 /* -----------------------------------------------------------------------
  * Description:
- *  Initialize the XT host subsystem.
+ *  Decodes the clock edges captured by the clock ISRs of all instances
+ *  into scan codes and advances keyboard resets. Must be called 
+ *  periodically, received data and keyboard detection status are only 
+ *  updated by this function.
  *
  * Parameters:
  *  n/a
@@ -120,21 +137,46 @@ void XthXcvr_Disable(void);
  * Returns: 
  *  n/a
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-uint8_t XthXcvr_ReadReceivedData(void);
+void XthXcvr_Update(void);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Removes the oldest scan code from the receive queue. If the clock 
+ *  line was held because the queue was full, it is released.
+ *
+ * Parameters:
+ *  instance - transceiver instance
+ * 
+ * Returns: 
+ *  the received scan code, XT_SC_NONE if the queue is empty
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+uint8_t XthXcvr_ReadReceivedData(uint8_t instance);
 
 
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Clear the receive overflow status.
+ *
+ * Parameters:
+ *  instance - transceiver instance
+ * 
+ * Returns: 
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_ClearOverflow(uint8_t instance);
+
 /* -----------------------------------------------------------------------
  * Description:
  *  Issue a soft reset to the keyboard. The KBD_DETECTED status bit will 
  *  be cleared. 
  *
  * Parameters:
- *  n/a
+ *  instance - transceiver instance
  * 
  * Returns: 
  *  n/a
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_SoftReset(void);
+void XthXcvr_SoftReset(uint8_t instance);
 
 
 /* -----------------------------------------------------------------------
@@ -143,12 +185,77 @@ void XthXcvr_SoftReset(void);
  *  be issued and the KBD_DETECTED status bit will be cleared. 
  *
  * Parameters:
+ *  instance - transceiver instance
+ * 
+ * Returns: 
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_PowerOnReset(uint8_t instance);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Returns the number of start bits used by the keyboard. When protocol
+ *  detection is enabled this is determined from the first frame received
+ *  after a reset.
+ *
+ * Parameters:
+ *  instance - transceiver instance
+ * 
+ * Returns: 
+ *  1 or 2, 0 if detection has not completed
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+uint8_t XthXcvr_StartBits(uint8_t instance);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Returns the nominal keyboard clock period measured during protocol 
+ *  detection.
+ *
+ * Parameters:
+ *  instance - transceiver instance
+ * 
+ * Returns: 
+ *  clock period in microseconds, 0 if not measured
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+uint16_t XthXcvr_ClockPeriod(uint8_t instance);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Copies the receive statistics recorded by the transceiver. Statistics
+ *  are only recorded if XTH_XCVR_STATS_ENABLE is set.
+ *
+ * Parameters:
+ *  instance - transceiver instance
+ *  stats    - receives a copy of the statistics
+ * 
+ * Returns: 
+ *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_GetStats(uint8_t instance, XthXcvrStats* stats);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Clears the receive statistics.
+ *
+ * Parameters:
+ *  instance - transceiver instance
+ * 
+ * Returns: 
  *  n/a
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+void XthXcvr_ResetStats(uint8_t instance);
+
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Sends the receive statistics to the console.
+ *
+ * Parameters:
+ *  instance - transceiver instance
  * 
  * Returns: 
  *  n/a
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-void XthXcvr_HardReset(void);
+void XthXcvr_ReportStats(uint8_t instance);
 
 
 #endif /* XT_HOST_H_ */
\ No newline at end of file
@@ -11,14 +11,73 @@
 
 #include "config.h"
 
+/* Number of XT keyboards received, a second keyboard requires the
+ * XTH_XCVR_CLOCK2_ and XTH_XCVR_DATA2_ pins */
+#ifndef XTH_XCVR_INSTANCES
+    #define XTH_XCVR_INSTANCES 1
+#endif
+
+#if XTH_XCVR_INSTANCES < 1 || XTH_XCVR_INSTANCES > 2
+    #error "XTH_XCVR_INSTANCES must be 1 or 2."
+#endif
+
 #ifndef XTH_XCVR_SOF_THRESHOLD
     #define XTH_XCVR_SOF_THRESHOLD 200U /* Microseconds */
 #endif
 
+#ifndef XTH_XCVR_GLITCH_THRESHOLD
+    #define XTH_XCVR_GLITCH_THRESHOLD 10U /* Microseconds, 0 disables */
+#endif
+
+#ifndef XTH_XCVR_STATS_ENABLE
+    #ifdef USE_CONSOLE
+        #define XTH_XCVR_STATS_ENABLE 1
+    #else
+        #define XTH_XCVR_STATS_ENABLE 0
+    #endif
+#endif
+
+/* Number of scan codes queued by the receiver before the clock line is
+ * held low. Must be a power of 2, 1 holds the clock after every scan code */
+#ifndef XTH_XCVR_RECV_QUEUE_SIZE
+    #define XTH_XCVR_RECV_QUEUE_SIZE 8
+#endif
+
+#if (XTH_XCVR_RECV_QUEUE_SIZE & (XTH_XCVR_RECV_QUEUE_SIZE - 1)) || XTH_XCVR_RECV_QUEUE_SIZE > 128
+    #error "XTH_XCVR_RECV_QUEUE_SIZE must be a power of 2 no greater than 128."
+#endif
+
+/* Number of clock edges captured by the clock ISRs awaiting decoding by
+ * XthXcvr_Update(), shared by all instances. A frame is 9 or 10 edges. 
+ * A clock line is held low at the end of a frame once the queue cannot
+ * take another frame from every instance. Must be a power of 2 larger
+ * than 10 edges per instance */
+#ifndef XTH_XCVR_EDGE_QUEUE_SIZE
+    #define XTH_XCVR_EDGE_QUEUE_SIZE 32
+#endif
+
+#if (XTH_XCVR_EDGE_QUEUE_SIZE & (XTH_XCVR_EDGE_QUEUE_SIZE - 1)) || XTH_XCVR_EDGE_QUEUE_SIZE > 128 || XTH_XCVR_EDGE_QUEUE_SIZE < 16
+    #error "XTH_XCVR_EDGE_QUEUE_SIZE must be a power of 2 from 16 to 128."
+#endif
+
 #ifndef XTH_XCVR_1_START_BIT
     #define XTH_XCVR_1_START_BIT 0
 #endif
 
+/* Detect the start bit variant and clock period from the first frame
+ * received after a reset. XTH_XCVR_1_START_BIT and XTH_XCVR_SOF_THRESHOLD
+ * are used until the first frame has been received. */
+#ifndef XTH_XCVR_PROTOCOL_DETECT
+    #define XTH_XCVR_PROTOCOL_DETECT 1
+#endif
+
+/* Consecutive framing errors, i.e. bad start bits and frames cut short
+ * by a start of frame, after which a detected protocol is discarded and
+ * detected again from the next frame */
+#ifndef XTH_XCVR_PROTOCOL_RELOCK_ERRORS
+    #define XTH_XCVR_PROTOCOL_RELOCK_ERRORS 4
+#endif
+
 #ifndef XTH_XCVR_RESET_LINE_ENABLE
     #define XTH_XCVR_RESET_LINE_ENABLE 0
 #endif
@@ -20,26 +20,35 @@
 #include "common.h"
 
 
-/* Forward declaration of functions that must be implemented by the HAL */
+/* Forward declaration of functions that must be implemented by the HAL.
+ * Clock and data line functions take the transceiver instance, the HAL 
+ * maps each instance to its pins. The reset line and the start of frame 
+ * timer are shared by all instances. */
 
 
 /* -----------------------------------------------------------------------
 * Description:
 *  Initializes the XT clock line.
 *
+* Parameters:
+*  instance - transceiver instance
+*
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline void XthXcvrHal_ClockInit(void);
+static inline void XthXcvrHal_ClockInit(uint8_t instance);
 
 /* -----------------------------------------------------------------------
 * Description:
 *  Initializes the XT data line.
 *
+* Parameters:
+*  instance - transceiver instance
+*
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline void XthXcvrHal_DataInit(void);
+static inline void XthXcvrHal_DataInit(uint8_t instance);
 
 /* -----------------------------------------------------------------------
 * Description:
@@ -50,14 +59,29 @@ static inline void XthXcvrHal_DataInit(void);
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 static inline void XthXcvrHal_ResetInit(void);
 
+/* -----------------------------------------------------------------------
+* Description:
+*  Read the state of the XT clock line determine if it high
+*
+* Parameters:
+*  instance - transceiver instance
+*
+* Returns: bool
+*  true if CLOCK line is HIGH
+* . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline bool XthXcvrHal_ClockIsHigh(uint8_t instance);
+
 /* -----------------------------------------------------------------------
 * Description:
 *  Read the state of the XT data line determine if it high
 *
+* Parameters:
+*  instance - transceiver instance
+*
 * Returns: bool
 *  true if DATA line is HIGH
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline bool XthXcvrHal_DataIsHigh(void);
+static inline bool XthXcvrHal_DataIsHigh(uint8_t instance);
 
 /* -----------------------------------------------------------------------
 * Description:
@@ -67,38 +91,50 @@ static inline bool XthXcvrHal_DataIsHigh(void);
 *  Global interrupts must be enabled after this function is called in
 *  order for the interrupt to fire.
 *
+* Parameters:
+*  instance - transceiver instance
+*
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 
-static inline void XthXcvrHal_EnableClockInterrupt(void);
+static inline void XthXcvrHal_EnableClockInterrupt(uint8_t instance);
 
 /* -----------------------------------------------------------------------
 * Description:
 *  Disables the interrupt for the clock line
 *
+* Parameters:
+*  instance - transceiver instance
+*
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline void XthXcvrHal_DisableClockInterrupt(void);
+static inline void XthXcvrHal_DisableClockInterrupt(uint8_t instance);
 
 /* -----------------------------------------------------------------------
 * Description:
 *  Set clock line as output and pull low.
 *
+* Parameters:
+*  instance - transceiver instance
+*
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline void XthXcvrHal_ClockHoldLow(void);
+static inline void XthXcvrHal_ClockHoldLow(uint8_t instance);
 
 /* -----------------------------------------------------------------------
 * Description:
 *  Set clock as input and release.
 *
+* Parameters:
+*  instance - transceiver instance
+*
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline void XthXcvrHal_ClockRelease(void);
+static inline void XthXcvrHal_ClockRelease(uint8_t instance);
 
 
 /* -----------------------------------------------------------------------
@@ -121,60 +157,54 @@ static inline void XthXcvrHal_ResetHoldLow(void);
 
 /* -----------------------------------------------------------------------
 * Description:
-*  Start the timer with configuration to detect start of data frame
+*  Start the free running start of frame timer and enable its overflow
+*  interrupt. Each instance measures the time between its clock edges 
+*  from the difference in counts.
 *
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 static inline void XthXcvrHal_TimerSofStart(void);
 
-
-/* -----------------------------------------------------------------------
-* Description:
-*  Start the timer with configuration to support a timeout 
-*
-* Returns:
-*  n/a
-* . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline void XthXcvrHal_TimerResetStart(void);
-
 /* -----------------------------------------------------------------------
 * Description:
-*  Stop the timer
+*  Stop the timer and disable its overflow interrupt
 *
 * Returns:
 *  n/a
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 static inline void XthXcvrHal_TimerStop(void);
 
-/* -----------------------------------------------------------------------
-* Description:
-*  Reset the timer counter to 0
-*
-* Returns:
-*  n/a
-* . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
-static inline void XthXcvrHal_TimerSofCountReset(void);
-
 /* -----------------------------------------------------------------------
 * Description:
 *  Get the current timer count
 *
-* Returns: uint8_t
-*  The current timer count
+* Returns: uint16_t
+*  The current timer count, wraps after XTH_XCVR_SOF_TIMER_MAX
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 static inline uint16_t XthXcvrHal_TimerSofCount(void);
 
 
 /* -----------------------------------------------------------------------
 * Description:
-*  Determine if the timer has overflowed.
+*  Determine if the timer has overflowed and the overflow interrupt has
+*  not yet run.
 *
 * Returns: bool
 *  true if the timer overflowed
 * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 static inline bool XthXcvrHal_TimerSofOverflow(void);
 
+/* -----------------------------------------------------------------------
+* Description:
+*  Clear a pending timer overflow, used when the overflow is handled
+*  outside the overflow interrupt.
+*
+* Returns:
+*  n/a
+* . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static inline void XthXcvrHal_TimerSofClearOverflow(void);
+
 /* Include the appropriate HAL implementation */
 #if ARCH == AVR8
     #include "xth_xcvr_hal_avr.h"
@@ -187,9 +217,13 @@ static inline bool XthXcvrHal_TimerSofOverflow(void);
     #error XTH_XCVR_CLOCK_ISR not defined
 #endif
 
-/* Ensure that the HAL implementation has defined the reset timeout ISR */
-#if !defined (XTH_XCVR_RESET_TIMEOUT_ISR)
-    #error XTH_XCVR_RESET_TIMEOUT_ISR not defined
+#if XTH_XCVR_INSTANCES > 1 && !defined (XTH_XCVR_CLOCK2_ISR)
+    #error XTH_XCVR_CLOCK2_ISR not defined
+#endif
+
+/* Ensure that the HAL implementation has defined the timer overflow ISR */
+#if !defined (XTH_XCVR_TIMER_OVERFLOW_ISR)
+    #error XTH_XCVR_TIMER_OVERFLOW_ISR not defined
 #endif
 
 
@@ -73,6 +73,44 @@
     #error XTH_XCVR_RESET_BIT not defined
 #endif
 
+#if XTH_XCVR_INSTANCES > 1
+    #ifndef XTH_XCVR_CLOCK2_PORT
+        #error XTH_XCVR_CLOCK2_PORT not defined
+    #endif
+
+    #ifndef XTH_XCVR_CLOCK2_PINS
+        #error XTH_XCVR_CLOCK2_PINS not defined
+    #endif
+
+    #ifndef XTH_XCVR_CLOCK2_DDR
+        #error XTH_XCVR_CLOCK2_DDR not defined
+    #endif
+
+    #ifndef XTH_XCVR_CLOCK2_BIT
+        #error XTH_XCVR_CLOCK2_BIT not defined
+    #endif
+
+    #ifndef XTH_XCVR_DATA2_PORT
+        #error XTH_XCVR_DATA2_PORT not defined
+    #endif
+
+    #ifndef XTH_XCVR_DATA2_PINS
+        #error XTH_XCVR_DATA2_PINS not defined
+    #endif
+
+    #ifndef XTH_XCVR_DATA2_DDR
+        #error XTH_XCVR_DATA2_DDR not defined
+    #endif
+
+    #ifndef XTH_XCVR_DATA2_BIT
+        #error XTH_XCVR_DATA2_BIT not defined
+    #endif
+
+    #ifndef XTH_XCVR_CLOCK2_INTERRUPT
+        #error XTH_XCVR_CLOCK2_INTERRUPT not defined
+    #endif
+#endif
+
 #define XSTR(x) #x
 #define STR(x) XSTR(x)
 
@@ -80,61 +118,119 @@
     #error XTH_XCVR_CLOCK_INTERRUPT not defined
 #endif
 
-#if XTH_XCVR_CLOCK_INTERRUPT > 3 
+#if defined (EICRB)
+    #if XTH_XCVR_CLOCK_INTERRUPT > 7 || (XTH_XCVR_INSTANCES > 1 && XTH_XCVR_CLOCK2_INTERRUPT > 7)
+        #error XTH_XCVR_CLOCK_INTERRUPT must be INT0 to INT7
+    #endif
+#elif XTH_XCVR_CLOCK_INTERRUPT > 3 || (XTH_XCVR_INSTANCES > 1 && XTH_XCVR_CLOCK2_INTERRUPT > 3)
     #error XTH_XCVR_CLOCK_INTERRUPT must be INT0, INT1, INT2 or INT3
 #endif
 
 #define MAKE_VECTOR_CAT(a) INT ## a ##_vect
 #define MAKE_VECTOR(a) MAKE_VECTOR_CAT(a)  
 #define XTH_XCVR_CLOCK_INTERRUPT_VECTOR MAKE_VECTOR(XTH_XCVR_CLOCK_INTERRUPT)
+#define XTH_XCVR_CLOCK2_INTERRUPT_VECTOR MAKE_VECTOR(XTH_XCVR_CLOCK2_INTERRUPT)
 
-/* Reset timeout fires once per millisecond  */
-#define RESET_TIMEOUT_PRESCALER 64
-#define XTH_XCVR_RESET_TIMEOUT_MATCH ((F_CPU / RESET_TIMEOUT_PRESCALER / 1000U))
+/* Start of frame timer, free running. The count must not wrap within a
+ * clock period, an 8 bit timer is run at 2us per count. */
+#if defined (__AVR_ATmega328P__)
+    #define XTH_XCVR_SOF_PRESCALER 32
+    #define XTH_XCVR_SOF_TIMER_MAX 0xFFU
+#elif defined (__AVR_ATmega32U4__)
+    #define XTH_XCVR_SOF_PRESCALER 8
+    #define XTH_XCVR_SOF_TIMER_MAX 0xFFFFU
+#elif defined (__AVR_ATtiny85__)
+    #define XTH_XCVR_SOF_PRESCALER 16
+    #define XTH_XCVR_SOF_TIMER_MAX 0xFFU
+#endif
 
-#define XTH_XCVR_SOF_PRESCALER 8
-#define XTH_XCVR_SOF_MULTIPLIER (F_CPU/XTH_XCVR_SOF_PRESCALER/1000000)
+#define XTH_XCVR_US_TO_SOF_COUNT(us) ((uint16_t)((uint32_t)(us) * (F_CPU / 1000000UL) / XTH_XCVR_SOF_PRESCALER))
+#define XTH_XCVR_SOF_COUNT_TO_US(count) ((uint16_t)((uint32_t)(count) * XTH_XCVR_SOF_PRESCALER / (F_CPU / 1000000UL)))
 
-static inline void XthXcvrHal_ConfigureClockInterruptTrigger(TriggerMode mode)
+/* Clock and data pins of a transceiver instance */
+typedef struct _XthXcvrHalPins
 {
+    volatile uint8_t* clockPort;
+    volatile uint8_t* clockPins;
+    volatile uint8_t* clockDdr;
+    uint8_t clockMask;
+    volatile uint8_t* dataPort;
+    volatile uint8_t* dataPins;
+    volatile uint8_t* dataDdr;
+    uint8_t dataMask;
+    uint8_t interrupt;  /* n of the INTn external interrupt */
+} XthXcvrHalPins;
+
+/* Constant so accesses with a constant instance, e.g. in the clock ISRs,
+ * compile to direct port accesses */
+static const XthXcvrHalPins _xthXcvrHalPins[XTH_XCVR_INSTANCES] = {
+    {
+        &XTH_XCVR_CLOCK_PORT, &XTH_XCVR_CLOCK_PINS, &XTH_XCVR_CLOCK_DDR, (1 << XTH_XCVR_CLOCK_BIT),
+        &XTH_XCVR_DATA_PORT, &XTH_XCVR_DATA_PINS, &XTH_XCVR_DATA_DDR, (1 << XTH_XCVR_DATA_BIT),
+        XTH_XCVR_CLOCK_INTERRUPT
+    },
+#if XTH_XCVR_INSTANCES > 1
+    {
+        &XTH_XCVR_CLOCK2_PORT, &XTH_XCVR_CLOCK2_PINS, &XTH_XCVR_CLOCK2_DDR, (1 << XTH_XCVR_CLOCK2_BIT),
+        &XTH_XCVR_DATA2_PORT, &XTH_XCVR_DATA2_PINS, &XTH_XCVR_DATA2_DDR, (1 << XTH_XCVR_DATA2_BIT),
+        XTH_XCVR_CLOCK2_INTERRUPT
+    },
+#endif
+};
+
+static inline void XthXcvrHal_ConfigureClockInterruptTrigger(uint8_t instance, TriggerMode mode)
+{
+    uint8_t interrupt = _xthXcvrHalPins[instance].interrupt;
+    volatile uint8_t* eicr = &EICRA;
+    uint8_t trigger;
+
+#if defined (EICRB)
+    if (interrupt > 3) {
+        eicr = &EICRB;
+        interrupt -= 4;
+    }
+#endif
+
     switch(mode)
     {
         case TRIG_MODE_LOGIC_CHANGE:
-            EICRA &= ~(3 << (XTH_XCVR_CLOCK_INTERRUPT * 2));
-            EICRA |= (1 << (XTH_XCVR_CLOCK_INTERRUPT * 2)); 
+            trigger = 1;
             break;
 
         case TRIG_MODE_FALLING:
-            EICRA &= ~(3 << (XTH_XCVR_CLOCK_INTERRUPT * 2));
-            EICRA |= (2 << (XTH_XCVR_CLOCK_INTERRUPT * 2)); 
+            trigger = 2;
             break;
 
         case TRIG_MODE_RISING:
-            EICRA &= ~(3 << (XTH_XCVR_CLOCK_INTERRUPT * 2));
-            EICRA |= (3 << (XTH_XCVR_CLOCK_INTERRUPT * 2)); 
+            trigger = 3;
             break;
         default:
-            break;
+            return;
     }
+
+    *eicr &= ~(3 << (interrupt * 2));
+    *eicr |= (trigger << (interrupt * 2)); 
 }
 
-static inline void XthXcvrHal_EnableClockInterrupt(void)
+static inline void XthXcvrHal_EnableClockInterrupt(uint8_t instance)
 {
-    EIMSK |= (1 << XTH_XCVR_CLOCK_INTERRUPT); 
+    EIMSK |= (1 << (INT0 + _xthXcvrHalPins[instance].interrupt)); 
 }
 
-static inline void XthXcvrHal_DisableClockInterrupt(void)
+static inline void XthXcvrHal_DisableClockInterrupt(uint8_t instance)
 {
-    EIMSK &= ~(1 << XTH_XCVR_CLOCK_INTERRUPT);
+    EIMSK &= ~(1 << (INT0 + _xthXcvrHalPins[instance].interrupt));
 }
 
-static inline void XthXcvrHal_ClockInit(void)
+static inline void XthXcvrHal_ClockInit(uint8_t instance)
 {
+    const XthXcvrHalPins* pins = &_xthXcvrHalPins[instance];
+
     /* Configure clock pin as an input */
-    XTH_XCVR_CLOCK_DDR  &= ~(1 << XTH_XCVR_CLOCK_BIT);
+    *pins->clockDdr &= ~pins->clockMask;
 
     /* Enable internal pullup for clock pin */
-    XTH_XCVR_CLOCK_PORT |= (1 << XTH_XCVR_CLOCK_BIT);
+    *pins->clockPort |= pins->clockMask;
 
     /* Note: since we are the host, the keyboard will be driving the 
        clock line. Enable the pullup to give a default state of high.
@@ -142,17 +238,19 @@ static inline void XthXcvrHal_ClockInit(void)
 
     /* Configure generation of interrupt on falling edge with
      * interrupt disabled */
-	XthXcvrHal_DisableClockInterrupt();
-    XthXcvrHal_ConfigureClockInterruptTrigger(TRIG_MODE_FALLING);
+	XthXcvrHal_DisableClockInterrupt(instance);
+    XthXcvrHal_ConfigureClockInterruptTrigger(instance, TRIG_MODE_FALLING);
 }
 
-static inline void XthXcvrHal_DataInit(void)
+static inline void XthXcvrHal_DataInit(uint8_t instance)
 {
+    const XthXcvrHalPins* pins = &_xthXcvrHalPins[instance];
+
     /* Configure data pin as and input */
-    XTH_XCVR_DATA_DDR  &= ~(1<<XTH_XCVR_DATA_BIT);
+    *pins->dataDdr &= ~pins->dataMask;
 
     /* Enable internal pullup for data pin */
-    XTH_XCVR_DATA_PORT |=  (1<<XTH_XCVR_DATA_BIT);
+    *pins->dataPort |= pins->dataMask;
 
    
     /* Note: since we are the host, the keyboard will be driving the 
@@ -167,28 +265,32 @@ static inline void XthXcvrHal_ResetInit(void)
     XTH_XCVR_RESET_PORT &= ~(1<<XTH_XCVR_RESET_BIT);  
 }
 
-static inline bool XthXcvrHal_ClockIsHigh(void)
+static inline bool XthXcvrHal_ClockIsHigh(uint8_t instance)
 {
-    return (XTH_XCVR_CLOCK_PINS & (1 << XTH_XCVR_CLOCK_BIT));
+    return (*_xthXcvrHalPins[instance].clockPins & _xthXcvrHalPins[instance].clockMask);
 }
 
 
-static inline void XthXcvrHal_ClockHoldLow(void)
+static inline void XthXcvrHal_ClockHoldLow(uint8_t instance)
 {
-    XTH_XCVR_CLOCK_DDR |= (1 << XTH_XCVR_CLOCK_BIT); /* Set as output */
-    XTH_XCVR_CLOCK_PORT &= (0 << XTH_XCVR_CLOCK_BIT); /* Pull low */
+    const XthXcvrHalPins* pins = &_xthXcvrHalPins[instance];
+
+    *pins->clockDdr |= pins->clockMask;     /* Set as output */
+    *pins->clockPort &= ~pins->clockMask;   /* Pull low */
 }
 
-static inline void XthXcvrHal_ClockRelease(void)
+static inline void XthXcvrHal_ClockRelease(uint8_t instance)
 {
-    XTH_XCVR_CLOCK_DDR &= ~(1 << XTH_XCVR_CLOCK_BIT); /* Set as input */
-    XTH_XCVR_CLOCK_PORT &= (0 << XTH_XCVR_CLOCK_BIT); /* Ensure pullup is off */
+    const XthXcvrHalPins* pins = &_xthXcvrHalPins[instance];
+
+    *pins->clockDdr &= ~pins->clockMask;    /* Set as input */
+    *pins->clockPort &= ~pins->clockMask;   /* Ensure pullup is off */
 }
 
 
-static inline bool XthXcvrHal_DataIsHigh(void)
+static inline bool XthXcvrHal_DataIsHigh(uint8_t instance)
 {
-    return (XTH_XCVR_DATA_PINS & (1 << XTH_XCVR_DATA_BIT));
+    return (*_xthXcvrHalPins[instance].dataPins & _xthXcvrHalPins[instance].dataMask);
 }
 
 
@@ -215,37 +317,26 @@ static inline void XthXcvrHal_ResetHoldLow(void)
 
 
 
-static inline void XthXcvrHal_TimerResetStart(void)
-{
-    /* Enable timer by setting prescaler 
-	 * Enable interrupt of TOP match */
-    /* Enable timer by setting prescaler */
-    /* Enable CTC mode */
-#if defined (__AVR_ATmega328P__)
-    TCCR2B |= (1 << CS22 | 1 << WGM21); /* clk/64 */
-    TIMSK2 |= (1 << OCIE2A);
-    OCR2A = XTH_XCVR_RESET_TIMEOUT_MATCH;
-#elif defined (__AVR_ATmega32U4__)
-    TCCR1B = ( 1 << CS11 | 1 << CS10 | 1 << WGM12);  /* clk/64 */
-    TIMSK1 |= (1 << OCIE1A);
-    OCR1A = XTH_XCVR_RESET_TIMEOUT_MATCH;
-#elif defined (USE_TIM1_8)
-    TCCR1 |= (1 << CS12 | 1 << CS11 | 1 << CS10 | 1 << CTC1);  /* clk/64 */
-    TIMSK |=(1 << OCIE1A);
-    OCR1A = XTH_XCVR_RESET_TIMEOUT_MATCH;
-    OCR1C = XTH_XCVR_RESET_TIMEOUT_MATCH;
-#endif
-}
-
 static inline void XthXcvrHal_TimerSofStart(void)
 {
-    XthXcvrHal_TimerSofCountReset();
+    /* Normal mode, counts from 0 to TIMER_MAX and wraps */
 #if defined (__AVR_ATmega328P__)
-    TCCR2B |= (1 << CS21); /* clk\8 */
+    TCCR2A = 0;
+    TCNT2 = 0;
+    TIFR2 = (1 << TOV2);
+    TIMSK2 |= (1 << TOIE2);
+    TCCR2B = (1 << CS21 | 1 << CS20); /* clk\32 */
 #elif defined (__AVR_ATmega32U4__)
+    TCCR1A = 0;
+    TCNT1 = 0;
+    TIFR1 = (1 << TOV1);
+    TIMSK1 |= (1 << TOIE1);
     TCCR1B = (1 << CS11); /* clk\8 */
 #elif defined (__AVR_ATtiny85__)
-    TCCR1 |= (1 << CS12); /* clk\8 */
+    TCNT1 = 0;
+    TIFR = (1 << TOV1);
+    TIMSK |= (1 << TOIE1);
+    TCCR1 = (1 << CS12 | 1 << CS10); /* clk\16 */
 #endif
 }
 
@@ -253,14 +344,14 @@ static inline void XthXcvrHal_TimerStop(void)
 {
 #if defined (__AVR_ATmega328P__)
 	TCCR2B = 0;
-    TIMSK2 = 0;
+    TIMSK2 &= ~(1 << TOIE2);
 #elif defined (__AVR_ATmega32U4__)
     TCCR1A = 0;
     TCCR1B = 0;
-    TIMSK1 = 0;
+    TIMSK1 &= ~(1 << TOIE1);
 #elif defined (__AVR_ATtiny85__)
     TCCR1 = 0;
-    TIMSK = 0;
+    TIMSK &= ~(1 << TOIE1);
 #endif
 
 }
@@ -277,18 +368,13 @@ static inline uint16_t XthXcvrHal_TimerSofCount(void)
 
 }
 
-/* Reset counter 
- * Clear overflow flag */
-static inline void XthXcvrHal_TimerSofCountReset(void)
+static inline void XthXcvrHal_TimerSofClearOverflow(void)
 {
 #if defined (__AVR_ATmega328P__)
-	TCNT2 = 0;
     TIFR2 = (1 << TOV2);
 #elif defined (__AVR_ATmega32U4__)
-    TCNT1 = 0;
     TIFR1 = (1 << TOV1);
 #elif defined (__AVR_ATtiny85__)
-    TCNT1 = 0;
 	TIFR = (1 << TOV1);
 #endif
 }
@@ -307,16 +393,17 @@ static inline bool XthXcvrHal_TimerSofOverflow(void)
 }
 
 
-/* Definition of clock line interrupt vector */
+/* Definition of clock line interrupt vectors */
 #define XTH_XCVR_CLOCK_ISR() ISR(XTH_XCVR_CLOCK_INTERRUPT_VECTOR)
+#define XTH_XCVR_CLOCK2_ISR() ISR(XTH_XCVR_CLOCK2_INTERRUPT_VECTOR)
 
 #if defined (__AVR_ATmega328P__)
-	#define XTH_XCVR_RESET_TIMEOUT_ISR() ISR(TIMER2_COMPA_vect)
+    #define XTH_XCVR_TIMER_OVERFLOW_ISR() ISR(TIMER2_OVF_vect)
 #elif defined (__AVR_ATmega32U4__)
-	#define XTH_XCVR_RESET_TIMEOUT_ISR() ISR(TIMER1_COMPA_vect)
+    #define XTH_XCVR_TIMER_OVERFLOW_ISR() ISR(TIMER1_OVF_vect)
 #elif defined (__AVR_ATtiny85__)
-	#define XTH_XCVR_RESET_TIMEOUT_ISR() ISR(TIMER1_COMPA_vect)
-#endif 
+    #define XTH_XCVR_TIMER_OVERFLOW_ISR() ISR(TIMER1_OVF_vect)
+#endif
 
 
 #endif /* XT_AVR_H_ */
\ No newline at end of file
@@ -4,6 +4,7 @@
 typedef enum _ConsoleMessageIdXt2Ps2
 {
     CON_MSG_XT2PS2_KEYMAPPED,
+    CON_MSG_XT2PS2_RELEASE_ALL,
 } ConsoleMessageIdXt2Ps2;
 
 #endif /* CON_MSG_XT2PS2_H */
\ No newline at end of file
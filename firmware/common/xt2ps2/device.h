@@ -60,6 +60,21 @@ void Device_Start(void);
 void Device_Update(void);
 
 
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Determines if the Device subsystem is ready to send key events to the
+ *  remote host. While the device is not ready, key events should be left
+ *  queued in the Host subsystem.
+ *
+ * Parameters:
+ *  n/a
+ *
+ * Returns: bool
+ *  true  - if key events can be sent
+ *  false - if the device is still initializing
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Device_IsReady(void);
+
 /* -----------------------------------------------------------------------
  * Description:
  *  Send the specified KeyEvent to the remote host.
@@ -72,4 +87,15 @@ void Device_Update(void);
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Device_SendKeyEvent(KeyEvent* keyEvent);
 
+/* -----------------------------------------------------------------------
+ * Description:
+ *  Sends a release for every key the remote host has seen pressed and
+ *  not released, e.g. when the host enables scanning again. Later 
+ *  releases of those keys are discarded.
+ *
+ * Returns: uint8_t
+ *  The number of keys released
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+uint8_t Device_ReleaseAll(void);
+
 #endif /* DEVICE_H_ */
\ No newline at end of file
@@ -15,16 +15,29 @@
 #include "ps2d_kbd.h"
 #include "circular_buffer_util.h"
 #include "keycode.h"
+#include "keyboard_state.h"
+
+#include "con_msg_xt2ps2.h"
+#include "console.h"
 
 StatusLedUpdateReceived _statusLedUpdateReceived;
 
+/* Scanning enabled by the host as of the last update */
+static bool _scanning = false;
+
+/* -----------------------------------------------------------------------
+ *  The host discards its key state when it resets the keyboard, so 
+ *  keys held across the reset are forgotten rather than released
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 bool BatHandler(void)
 {
+    KeyboardState_Reset();
     return true;
 }
 
 void LedStatusUpdate(Ps2LedStatus status)
 {
+    KeyboardState_SetLocks((LedStatus)status);
     _statusLedUpdateReceived((LedStatus)status);
 }
 
@@ -39,6 +52,7 @@ void ResetReceived(void)
 void Device_Init(StatusLedUpdateReceived statusLedUpdateHandler)
 {
     _statusLedUpdateReceived = statusLedUpdateHandler;
+    KeyboardState_Reset();
     Ps2dKbd_Init(&BatHandler, &LedStatusUpdate, &ResetReceived);
 }
 
@@ -60,18 +74,71 @@ void Device_Update(void)
 {
     /* Run the Ps2dKbd task */
     Ps2dKbd_Task();
+
+    /* Releases are discarded while the host has scanning disabled, send
+     * those of the keys the host still has down once it is re-enabled */
+    bool scanning = Ps2dKbd_IsEnabled();
+
+    if (scanning && !_scanning)
+        Device_ReleaseAll();
+
+    _scanning = scanning;
+}
+
+/* -----------------------------------------------------------------------
+ *  The device is ready once the PS/2 POR/BAT has completed.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool Device_IsReady(void)
+{
+    return !Ps2dKbd_IsResetting();
 }
 
 /* -----------------------------------------------------------------------
  *  Send the specified KeyEvent to the remote host. The KeyEvent is first
- *  mapped to the appropriate PS/2 code sequence. The sequence is then 
- *  sent via the PS/2 Keyboard module.
+ *  recorded in the shared keyboard state, then mapped to the appropriate
+ *  PS/2 code sequence. The sequence is then sent via the PS/2 Keyboard 
+ *  module.
+ *   - Events are discarded while scanning is disabled so the keyboard
+ *     state only holds the keys the host has seen pressed
+ *   - Releases of keys that are not pressed are discarded, e.g. those
+ *     already released by Device_ReleaseAll()
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Device_SendKeyEvent(KeyEvent* keyEvent)
 {
-    if (KeyEvent_Code(keyEvent) != KC_NONE)
+    KeyCode keyCode = KeyEvent_Code(keyEvent);
+
+    if (keyCode == KC_NONE || !Ps2dKbd_IsEnabled())
+        return;
+
+    if (KeyEvent_IsRelease(keyEvent) && !KeyboardState_IsPressed(keyCode))
+        return;
+
+    KeyboardState_OnKeyEvent(keyEvent);
+    Ps2dKbd_OnKeyEvent(keyEvent);
+}
+
+/* -----------------------------------------------------------------------
+ *  Release every pressed key in KeyCode order, which releases the 
+ *  modifiers after the keys they modify.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+uint8_t Device_ReleaseAll(void)
+{
+    KeyEvent release;
+    uint8_t released = 0;
+
+    for (uint8_t code = KC_NONE + 1; code < KEY_CODE_COUNT; code++)
     {
-        Ps2dKbd_OnKeyEvent(keyEvent);
+        if (!KeyboardState_IsPressed(code))
+            continue;
+
+        KeyEvent_Init(&release, KEY_ACTION_RELEASE, code);
+        Device_SendKeyEvent(&release);
+        released++;
     }
+
+    if (released > 0)
+        CONSOLE_SEND8(CON_SRC_XT2PS2, CON_SEV_TRACE_EVENT, CON_MSG_XT2PS2_RELEASE_ALL, released);
+
+    return released;
 }
 
@@ -16,9 +16,12 @@
 #include "host.h"
 #include "keymap.h"
 #include "xth_xcvr.h"
+#include "xth_xcvr_config.h"
 #include "xth_kbd.h"
+#include "xt_scancode.h"
 #include "keyevent.h"
 #include "keycode.h"
+#include "modifier_status.h"
 
 #include "console.h"
 
@@ -26,7 +29,16 @@
 static uint8_t _keyEventQueueStorage[KEYEVENT_QUEUE_SIZE * sizeof(KeyEvent)];
 static CircularBuffer _keyEventQueue;
 
+/* Modifiers held on each keyboard. Keyboards share the modifiers, one 
+ * is pressed when the first keyboard presses it and released when the 
+ * last keyboard holding it releases it. */
+static ModifierStatus _modifiers[XTH_XCVR_INSTANCES];
+
+/* Keyboard to serve first on the next update */
+static uint8_t _nextInstance;
+
 static bool ToKeyEvent(uint8_t scanCode, KeyEvent* keyEvent);
+static bool MergeModifier(uint8_t instance, KeyEvent* keyEvent);
 
 /* -----------------------------------------------------------------------
  *  Calls XT host Xth_Init() function
@@ -39,6 +51,9 @@ static bool ToKeyEvent(uint8_t scanCode, KeyEvent* keyEvent);
     Keymap_Init();
     XthKbd_Init();
     CircularBuffer_Init(&_keyEventQueue, _keyEventQueueStorage, sizeof(_keyEventQueueStorage));
+
+    for (uint8_t instance = 0; instance < XTH_XCVR_INSTANCES; instance++)
+        ModifierStatus_Clear(&_modifiers[instance]);
  }
 
 
@@ -51,9 +66,12 @@ void Host_Start(void)
 }
 
 /* -----------------------------------------------------------------------
- *  Checks to see if data has been received from the XT device. If so, 
+ *  Checks to see if data has been received from the XT devices. If so, 
  *  invokes Keymap to map the scan code to one or more KeyEvent objects
  *  which are added to the key event queue.
+ *  Scan codes are left in the XT scan code buffer while the key event
+ *  queue is full, e.g. while the device is still initializing.
+ *  Keyboards are served in turn, one scan code each per update.
  * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
 void Host_Update(void)
 {
@@ -61,13 +79,24 @@ void Host_Update(void)
 
     XthKbd_Task();
 
-    if (XthKbd_IsScanCodeAvailable())
+    for (uint8_t i = 0; i < XTH_XCVR_INSTANCES; i++)
     {
-        uint8_t scanCode = XthKbd_GetScanCode();
+        uint8_t instance = _nextInstance;
+
+        if (++_nextInstance >= XTH_XCVR_INSTANCES)
+            _nextInstance = 0;
+
+        if (CircularBuffer_Size(&_keyEventQueue) - CircularBuffer_Count(&_keyEventQueue) < KEY_EVENT_SIZE)
+            return;
 
-        if (ToKeyEvent(scanCode, &keyEvent))
+        if (XthKbd_IsScanCodeAvailable(instance))
         {
-            CircularBuffer_InsertKeyEvent(&_keyEventQueue, &keyEvent);
+            uint8_t scanCode = XthKbd_GetScanCode(instance);
+
+            if (ToKeyEvent(scanCode, &keyEvent) && MergeModifier(instance, &keyEvent))
+            {
+                CircularBuffer_InsertKeyEvent(&_keyEventQueue, &keyEvent);
+            }
         }
     }
     return;
@@ -127,4 +156,41 @@ bool ToKeyEvent(uint8_t scanCode, KeyEvent* keyEvent)
     KeyEvent_Init(keyEvent, action, code);
 
     return true;
-}
\ No newline at end of file
+}
+
+/* -----------------------------------------------------------------------
+ *  Tracks the modifiers held on each keyboard. Determines if a modifier
+ *  event changes the merged state and should be passed on.
+ *   - Press is passed on if no other keyboard holds the modifier
+ *   - Release is passed on if no other keyboard still holds it
+ *   - Other keys are always passed on
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+bool MergeModifier(uint8_t instance, KeyEvent* keyEvent)
+{
+    Modifiers modifier;
+
+    switch (KeyEvent_Code(keyEvent))
+    {
+        case XT_SC_CONTROL:   modifier = MODS_LCTRL; break;
+        case XT_SC_LSHIFT:    modifier = MODS_LSHIFT; break;
+        case XT_SC_RSHIFT:    modifier = MODS_RSHIFT; break;
+        case XT_SC_ALT:       modifier = MODS_LALT; break;
+        case XT_SC_RCONTROL:  modifier = MODS_RCTRL; break;
+        case XT_SC_RALT:      modifier = MODS_RALT; break;
+        case XT_SC_LGUI:      modifier = MODS_LGUI; break;
+        case XT_SC_RGUI:      modifier = MODS_RGUI; break;
+        default:
+            return true;
+    }
+
+    bool heldElsewhere = false;
+    for (uint8_t other = 0; other < XTH_XCVR_INSTANCES; other++)
+    {
+        if (other != instance && ModifierStatus_IsDown(&_modifiers[other], modifier))
+            heldElsewhere = true;
+    }
+
+    ModifierStatus_Set(&_modifiers[instance], modifier, KeyEvent_IsPress(keyEvent));
+
+    return !heldElsewhere;
+}
@@ -0,0 +1,148 @@
+/* =======================================================================
+ * bench_decode.c
+ *
+ * Purpose:
+ *  Measures console_host decode throughput on a synthetic trace. The 
+ *  trace is generated in memory with the firmware's wire format and 
+ *  decoded with output echo disabled, first a byte at a time then in
+ *  blocks.
+ *
+ *  Usage: console_host_bench [message count] [raw file] [text file]
+ *
+ * License:
+ *  Copyright (c) 2015, Engicoder
+ *  All rights reserved.
+ *  See LICENSE.txt for license details.
+ * ----------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "console.h"
+#include "console_expansion.h"
+#include "con_exp_test.h"
+#include "con_exp_xth_xcvr.h"
+#include "con_exp_xth_kbd.h"
+#include "con_exp_ps2d_kbd.h"
+#include "con_exp_ps2d_xcvr.h"
+#include "con_exp_xt2ps2.h"
+#include "con_exp_keymap.h"
+
+#define DEFAULT_MESSAGE_COUNT 2000000UL
+#define BLOCK_SIZE 4096
+
+static const uint8_t messageLength[CON_MSG_COUNT] = { 2, 3, 4, 5, 6, 4, 6, 6, 5, 6, };
+
+/* Append one message, returns the number of bytes written */
+static size_t AppendMessage(uint8_t* out, uint8_t source, uint8_t type, uint8_t id,
+                            uint8_t sequence, uint16_t delta, bool marker)
+{
+    size_t length = 0;
+
+    if (marker)
+        out[length++] = CON_MSG_SYNC;
+
+    out[length++] = (uint8_t)(source << 4) | type;
+    out[length++] = id;
+    out[length++] = sequence;
+
+    while (delta > 0x7F) {
+        out[length++] = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+    }
+    out[length++] = (uint8_t)delta;
+
+    for (uint8_t i = CON_MSG_HEADER_LEN; i < messageLength[type]; i++)
+        out[length++] = (uint8_t)rand();
+
+    return length;
+}
+
+static size_t GenerateTrace(uint8_t* trace, unsigned long messageCount)
+{
+    size_t length = 0;
+    uint8_t sequence = 0;
+
+    /* Tick period message so timestamps convert to time */
+    uint8_t period[] = { CON_MSG_SYNC, (CON_SRC_CONSOLE << 4) | CON_MSG_DATA16, 
+                         CON_MSG_CONSOLE_TICK_PERIOD, sequence++, 0, 20, 0 };
+    for (size_t i = 0; i < sizeof(period); i++)
+        trace[length++] = period[i];
+
+    for (unsigned long i = 1; i < messageCount; i++)
+    {
+        uint8_t source = (uint8_t)(1 + rand() % (CON_SRC_COUNT - 1));
+        uint8_t type = (uint8_t)(rand() % CON_MSG_COUNT);
+        uint16_t delta = (uint16_t)(rand() % 4 ? rand() % 128 : rand() % 16384);
+
+        length += AppendMessage(&trace[length], source, type, (uint8_t)(rand() % 16),
+                                sequence, delta, sequence == 0);
+        sequence++;
+    }
+
+    return length;
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Report(const char* name, unsigned long messages, size_t bytes, double seconds)
+{
+    printf("%-12s %10lu messages %8.3f s %12.0f msg/s %8.1f MB/s\n", name, messages, seconds,
+           messages / seconds, bytes / seconds / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long messageCount = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_MESSAGE_COUNT;
+    char* rawFilename = (argc > 2) ? argv[2] : "/dev/null";
+    char* textFilename = (argc > 3) ? argv[3] : "/dev/null";
+
+    /* Worst case message: marker, 6 byte message, sequence, 3 byte timestamp */
+    uint8_t* trace = malloc(messageCount * 11);
+    if (trace == NULL)
+    {
+        fprintf(stderr, "Unable to allocate trace\n");
+        return 1;
+    }
+
+    srand(1);
+    size_t length = GenerateTrace(trace, messageCount);
+    printf("Synthetic trace: %lu messages, %lu bytes\n", messageCount, (unsigned long)length);
+
+    if (!ConsoleExpansion_Init(rawFilename, textFilename, "XT2PS2 Console Host Decode Benchmark"))
+        return 1;
+
+    ConsoleExpansion_SetEcho(false);
+    ConsoleExpansion_RegisterExpander(CON_SRC_TEST, testConsoleHandler, testSourceText);
+    ConsoleExpansion_RegisterExpander(CON_SRC_XTH_XCVR, xthXcvrConsoleHandler, xthXcvrSourceText);
+    ConsoleExpansion_RegisterExpander(CON_SRC_XTH_KBD, xthKbdConsoleHandler, xthKbdSourceText);
+    ConsoleExpansion_RegisterExpander(CON_SRC_PS2D_KBD, ps2dKbdConsoleHandler, ps2dKbdSourceText);
+    ConsoleExpansion_RegisterExpander(CON_SRC_PS2D_XCVR, ps2dXcvrConsoleHandler, ps2dXcvrSourceText);
+    ConsoleExpansion_RegisterExpander(CON_SRC_XT2PS2, xt2Ps2ConsoleHandler, xt2Ps2SourceText);
+    ConsoleExpansion_RegisterExpander(CON_SRC_KEYMAP, keymapConsoleHandler, keymapSourceText);
+
+    unsigned long start = ConsoleExpansion_MessageCount();
+    double begin = Now();
+    for (size_t i = 0; i < length; i++)
+        ConsoleExpansion_ProcessData(trace[i]);
+    Report("byte", ConsoleExpansion_MessageCount() - start, length, Now() - begin);
+
+    start = ConsoleExpansion_MessageCount();
+    begin = Now();
+    for (size_t i = 0; i < length; i += BLOCK_SIZE)
+        ConsoleExpansion_ProcessBuffer(&trace[i], (length - i < BLOCK_SIZE) ? length - i : BLOCK_SIZE);
+    Report("block", ConsoleExpansion_MessageCount() - start, length, Now() - begin);
+
+    ConsoleExpansion_Exit();
+    free(trace);
+
+    return 0;
+}
@@ -40,7 +40,14 @@ void Handler(char* out, ConsoleMessage* message)
         case CON_MSG_KEYMAP_SWAP:
             {
                 uint8_t data = message->data.type8.data1;
-                sprintf(out, "Keymap swap to: %s", keymapString[data]);
+                sprintf(out, "Keymap swap to: %s", CON_EXP_STRING(keymapString, data));
+            }
+            break;
+        case CON_MSG_KEYMAP_REMAP_RELEASE:
+            {
+                uint8_t data1 = message->data.type88.data1;
+                uint8_t data2 = message->data.type88.data2;
+                sprintf(out, "Remapped key %02X released as %02X", data1, data2);
             }
             break;
 
@@ -80,14 +80,14 @@ void Handler(char* out, ConsoleMessage* message)
         case CON_MSG_PS2D_KBD_TM_DELAY:
             {
                 uint16_t delay = message->data.type16.data1;
-                sprintf(out, "Typematic delay: %d ms", delay/clocksPerMs);
+                sprintf(out, "Typematic delay: %d ms", clocksPerMs ? delay/clocksPerMs : 0);
             }
             break;
 
         case CON_MSG_PS2D_KBD_TM_RATE:
             {
                 uint16_t rate = message->data.type16.data1;
-                sprintf(out, "Typematic rate: %d cps", 1000 * clocksPerMs / rate);
+                sprintf(out, "Typematic rate: %d cps", rate ? 1000 * clocksPerMs / rate : 0);
             }
             break;
 
@@ -95,7 +95,7 @@ void Handler(char* out, ConsoleMessage* message)
             {
                 uint8_t data = message->data.type8.data1;
                 if (data >= 0xED)
-                    sprintf(out, "CMD: %s", ps2CommandStrings[data - 0xED]);
+                    sprintf(out, "CMD: %s", CON_EXP_STRING(ps2CommandStrings, data - 0xED));
                 else
                     sprintf(out, "CMD: %02X - Unexepected", data);
             }
@@ -124,7 +124,7 @@ void Handler(char* out, ConsoleMessage* message)
                     default:
                         response = PS2_RESP_EMPTY;
                 }
-                sprintf(out, "RSP: %s", ps2ResponseStrings[response]);
+                sprintf(out, "RSP: %s", CON_EXP_STRING(ps2ResponseStrings, response));
             }
             break;
 
@@ -144,9 +144,10 @@ void Handler(char* out, ConsoleMessage* message)
 
          case CON_MSG_PS2D_KBD_KEYEVENT:
             {
-                uint8_t code = message->data.type88.data1;
-                uint8_t action = message->data.type88.data2;
-                sprintf(out, "KeyEvent: %02X %s", code, actionString[action]);
+                uint8_t code = message->data.type8888.data1;
+                uint8_t action = message->data.type8888.data2;
+                uint8_t length = message->data.type8888.data3;
+                sprintf(out, "KeyEvent: %02X %s, %d bytes sent", code, CON_EXP_STRING(actionString, action), length);
             }
             break;
 
@@ -160,7 +161,7 @@ void Handler(char* out, ConsoleMessage* message)
          case CON_MSG_PS2D_KBD_POR_START:
             {
                 uint16_t length = message->data.type16.data1;
-                sprintf(out, "POR started: %d", length);
+                sprintf(out, "POR started: %d ms", length);
             }
             break;
 
@@ -174,7 +175,7 @@ void Handler(char* out, ConsoleMessage* message)
          case CON_MSG_PS2D_KBD_BAT_START:
             {
                 uint16_t length = message->data.type16.data1;
-                sprintf(out, "BAT started: %d", length);
+                sprintf(out, "BAT started: %d ms", length);
             }
             break;
 
@@ -184,6 +185,27 @@ void Handler(char* out, ConsoleMessage* message)
             }
             break;
 
+         case CON_MSG_PS2D_KBD_HOST_READY:
+            {
+                ConsolePs2dKbdResetPhase phase = (ConsolePs2dKbdResetPhase)message->data.type8.data1;
+                sprintf(out, "Host ready: %s ended early", phase == CON_PS2D_KBD_PHASE_POR ? "POR" : "BAT");
+            }
+            break;
+
+         case CON_MSG_PS2D_KBD_BOOT_READY:
+            {
+                uint16_t time = message->data.type16.data1;
+                sprintf(out, "Boot to BAT result: %d ms", time);
+            }
+            break;
+
+         case CON_MSG_PS2D_KBD_BOOT_FIRST_KEY:
+            {
+                uint16_t time = message->data.type16.data1;
+                sprintf(out, "Boot to first key: %d ms", time);
+            }
+            break;
+
         default:
             sprintf(out, "Unknown Message: %02X", message->messageId);
             break;
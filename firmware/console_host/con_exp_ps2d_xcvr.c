@@ -55,7 +55,7 @@ void Handler(char* out, ConsoleMessage* message)
         case CON_MSG_PS2D_XCVR_XMIT_BUSY:
             {
                 uint8_t data = message->data.type8.data1;
-                sprintf(out, "Transmit: Bus not ready. State: %s", ps2dXcvrStateStrings[data]);
+                sprintf(out, "Transmit: Bus not ready. State: %s", CON_EXP_STRING(ps2dXcvrStateStrings, data));
             }
             break;
 
@@ -74,6 +74,16 @@ void Handler(char* out, ConsoleMessage* message)
             }
             break;
 
+        case CON_MSG_PS2D_XCVR_TICK_DELAY:
+            {
+                uint8_t counts = message->data.type88.data1;
+                uint8_t countsPerUs = message->data.type88.data2;
+                if (countsPerUs == 0)
+                    countsPerUs = 1;
+                sprintf(out, "Bus timer ISR delay max: %.1f us [%d counts]", (float)counts / countsPerUs, counts);
+            }
+            break;
+
 
         default:
             sprintf(out, "Unknown Message: %02X", message->messageId);
@@ -19,9 +19,15 @@ void Handler(char* out, ConsoleMessage* message)
     switch (message->messageId)
     {
         case CON_MSG_XT2PS2_KEYMAPPED:
+            {
+                sprintf(out, "Keymapped %02X to %02X", message->data.type88.data1, message->data.type88.data2);
+            }
+            break;
+
+        case CON_MSG_XT2PS2_RELEASE_ALL:
             {
                 uint8_t data = message->data.type8.data1;
-                sprintf(out, "Keymapped to %02X", data);
+                sprintf(out, "Released %u held keys", data);
             }
             break;
 
@@ -22,6 +22,22 @@ void Handler(char* out, ConsoleMessage* message)
             sprintf(out, "XT Keyboard detected.");
             break;
 
+        case CON_MSG_XTH_KBD_PROTOCOL:
+            sprintf(out, "Start bits: %d, clock period: %d us", message->data.type1616.data1, message->data.type1616.data2);
+            break;
+
+        case CON_MSG_XTH_KBD_CHATTER:
+            sprintf(out, "Chatter filtered: %02X", message->data.type8.data1);
+            break;
+
+        case CON_MSG_XTH_KBD_DEBOUNCE_STATS:
+            sprintf(out, "Debounce: %d filtered, %d settled", message->data.type1616.data1, message->data.type1616.data2);
+            break;
+
+        case CON_MSG_XTH_KBD_SCAN_CODE:
+            sprintf(out, "Scan code accepted: %02X", message->data.type8.data1);
+            break;
+
         default:
             out[0] = 0;
             break;
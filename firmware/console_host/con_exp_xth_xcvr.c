@@ -127,10 +127,26 @@ void Handler(char* out, ConsoleMessage* message)
             {
                 uint8_t data = message->data.type8.data1;
                 int action = ((data & (1 << 7))!= 0) ? 0 : 1;
-                sprintf(out, "%2X -> %s, %s", data, actionString[action], xtScanCodeStrings[(data & 0x7F)]);
+                sprintf(out, "%2X -> %s, %s", data, CON_EXP_STRING(actionString, action), CON_EXP_STRING(xtScanCodeStrings, data & 0x7F));
             }
             break;
 
+        case CON_MSG_XTH_XCVR_STATS_PERIOD:
+            sprintf(out, "Bit period: min %d us, max %d us", message->data.type1616.data1, message->data.type1616.data2);
+            break;
+
+        case CON_MSG_XTH_XCVR_STATS_FRAME:
+            sprintf(out, "SOF resyncs: %d, glitches: %d", message->data.type1616.data1, message->data.type1616.data2);
+            break;
+
+        case CON_MSG_XTH_XCVR_STATS_RECV:
+            sprintf(out, "Overflows: %d, 0xAA detects: %d", message->data.type1616.data1, message->data.type1616.data2);
+            break;
+
+        case CON_MSG_XTH_XCVR_PROTOCOL_RELOCK:
+            sprintf(out, "Keyboard %d: protocol detection restarted after framing errors", message->data.type8.data1);
+            break;
+
         default:
             out[0] = 0;
             break;
@@ -2,19 +2,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
-#include <windows.h>
-#include <windef.h>
-#include <winnt.h>
-#include <winbase.h>
 #include <string.h>
-#include <math.h>
-#include <sys/time.h>
 
 
 #include "console.h"
 #include "console_expansion.h"
 
 #define OUT_STRING_MAX 60
+#define OUT_LINE_MAX (OUT_STRING_MAX + SOURCE_TEXT_MAX_LEN + 32)
+
+/* Output file buffer size, decoded lines and raw data are written in 
+ * blocks rather than per byte */
+#define FILE_BUFFER_SIZE (64 * 1024)
 
 #define SOURCE_TEXT_MAX_LEN 10
 
@@ -32,8 +31,12 @@ ConsoleMessageExpander expanders[CON_SRC_COUNT];
 typedef enum _state
 {
     IDLE,
+    ID,
+    SEQUENCE,
+    TIMESTAMP,
     RECV,
     OUTPUT,
+    RESYNC,
 } State;
 
 
@@ -41,34 +44,80 @@ void DefaultMessageHandler(char* out, ConsoleMessage* message);
 char defaultSourceText[] = "UNKOWN";
 
 void ConsoleHandler(char* out, ConsoleMessage* message);
+static void DecodeByte(uint8_t data);
 char consoleSourceText[] = "CONSOLE";
 
 FILE* raw;
 FILE* decode;
 
-struct timeval timeVal;
-time_t nowtime;
-struct tm *nowtm;
-char tmbuf[64];
+#define OBSERVER_MAX 4
 
-bool ConsoleExpansion_Init(char* binaryFilename, char* textFilename, char* startupText)
+ConsoleMessageObserver observers[OBSERVER_MAX];
+int observerCount = 0;
+
+/* Echo decoded lines to stdout */
+bool echo = true;
+unsigned long messageCount = 0;
+
+/* Device time reconstructed from the message timestamp deltas */
+uint64_t deviceTicks = 0;
+uint16_t tickPeriod = 0; /* Microseconds, reported by the device */
+
+/* Sequence number tracking, unknown until the first message */
+bool sequenceValid = false;
+uint8_t expectedSequence = 0;
+unsigned long messagesLost = 0;
+
+/* Set when the current message follows a marker. Only a marker may skip
+ * sequence numbers, those dropped by the device. A gap anywhere else 
+ * means data was lost on the link and the message is discarded. */
+bool markerSeen = false;
+
+/* ------------------------------------------------------------------------
+ *  Report a framing or sequence problem to the console and decode file
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void ReportStreamError(const char* text, unsigned long value)
+{
+    char line[OUT_LINE_MAX];
+
+    snprintf(line, sizeof(line), "*** %s: %lu\n", text, value);
+    fputs(line, decode);
+    if (echo)
+        fputs(line, stdout);
+}
+
+static bool IsValidSourceType(uint8_t sourceType)
 {
+    return ((sourceType >> 4) < CON_SRC_COUNT) && ((sourceType & 0x0F) < CON_MSG_COUNT);
+}
 
-    raw = fopen(binaryFilename, "w+");
-    if (raw == NULL)
+bool ConsoleExpansion_Init(char* binaryFilename, char* textFilename, char* startupText)
+{
+    /* No raw output when replaying a capture */
+    raw = NULL;
+    if (binaryFilename != NULL)
     {
-        printf("Unable to open file to write raw data");
-        return false;
+        raw = fopen(binaryFilename, "w+");
+        if (raw == NULL)
+        {
+            printf("Unable to open file to write raw data");
+            return false;
+        }
     }
 
     decode = fopen(textFilename, "w+");
     if (decode == NULL)
     {
-        fclose(raw);
+        if (raw != NULL)
+            fclose(raw);
         printf("Unable to open file to write decoded data");
         return false;
     }
 
+    if (raw != NULL)
+        setvbuf(raw, NULL, _IOFBF, FILE_BUFFER_SIZE);
+    setvbuf(decode, NULL, _IOFBF, FILE_BUFFER_SIZE);
+
     printf("*\n");
     printf("%s\n", startupText);
     printf("*\n");
@@ -94,17 +143,55 @@ void ConsoleExpansion_RegisterExpander(ConsoleSource source, ConsoleMessageHandl
 
 void ConsoleExpansion_Exit(void)
 {
-    fclose(raw);
+    if (raw != NULL)
+        fclose(raw);
     fclose(decode);
 }
 
+void ConsoleExpansion_SetEcho(bool enable)
+{
+    echo = enable;
+}
+
+bool ConsoleExpansion_AddObserver(ConsoleMessageObserver observer)
+{
+    if (observerCount == OBSERVER_MAX)
+        return false;
+
+    observers[observerCount++] = observer;
+    return true;
+}
+
+unsigned long ConsoleExpansion_MessageCount(void)
+{
+    return messageCount;
+}
+
 void ConsoleExpansion_ProcessData(uint8_t data)
 {
-    fputc(data, raw);
+    ConsoleExpansion_ProcessBuffer(&data, 1);
+}
 
+void ConsoleExpansion_ProcessBuffer(const uint8_t* data, size_t length)
+{
+    if (raw != NULL)
+        fwrite(data, 1, length, raw);
+
+    for (size_t i = 0; i < length; i++)
+        DecodeByte(data[i]);
+}
+
+/* ------------------------------------------------------------------------
+ *  Advance the decoder by one byte, outputting completed messages
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void DecodeByte(uint8_t data)
+{
     static State state = IDLE;
     static ConsoleMessage message;
     static uint8_t byteCount;
+    static uint32_t delta;
+    static uint8_t deltaShift;
+    static uint8_t sequence;
     ConsoleMessageExpander* expander;
 
     char outString[OUT_STRING_MAX];
@@ -112,34 +199,83 @@ void ConsoleExpansion_ProcessData(uint8_t data)
     switch (state)
     {
         case IDLE:
+            if (data == CON_MSG_SYNC)
+            {
+                markerSeen = true;
+                break;
+            }
+
+            if (!IsValidSourceType(data))
+            {
+                ReportStreamError("Invalid message header, resynchronizing", data);
+                sequenceValid = false;
+                state = RESYNC;
+                break;
+            }
+
             message.sourceType = data;
-            gettimeofday(&timeVal, NULL);
-            nowtime = timeVal.tv_sec;
-            nowtm = localtime(&nowtime);
-            strftime(tmbuf, sizeof tmbuf, "%H:%M:%S", nowtm);
-            state = RECV;
+            state = ID;
             byteCount = 1;
             break;
 
-        case RECV:
-            message.messageBytes[byteCount] = data;
-            byteCount++;
-            ConsoleMessageType type = ConsoleMessage_Type(&message);
-            int length = consoleMessageLength[type];
-            if (byteCount == length)
+        case RESYNC:
+            /* Discard data until the next marker */
+            if (data == CON_MSG_SYNC)
             {
-                ConsoleSource source = ConsoleMessage_Source(&message);
-                if (source < CON_SRC_COUNT) {
-                    expander = &expanders[ConsoleMessage_Source(&message)];
-                    expander->handler(outString, &message);
-                    state = OUTPUT;
-                } else {
-                    printf("Message discarded, unknown source: %d\n", source);
-                    fprintf(decode, "Message discarded, unknown source: %d\n", source);
+                markerSeen = true;
+                state = IDLE;
+            }
+            break;
+
+        case ID:
+            message.messageId = data;
+            byteCount++;
+            state = SEQUENCE;
+            break;
 
+        case SEQUENCE:
+            if (sequenceValid && data != expectedSequence)
+            {
+                uint8_t lost = (uint8_t)(data - expectedSequence);
+                messagesLost += lost;
+
+                if (!markerSeen)
+                {
+                    ReportStreamError("Sequence gap, resynchronizing", lost);
+                    sequenceValid = false;
+                    state = RESYNC;
+                    break;
                 }
+                ReportStreamError("Messages lost", lost);
+            }
+            markerSeen = false;
+            sequenceValid = true;
+            sequence = data;
+            expectedSequence = data + 1;
+            delta = 0;
+            deltaShift = 0;
+            state = TIMESTAMP;
+            break;
+
+        case TIMESTAMP:
+            delta |= (uint32_t)(data & 0x7F) << deltaShift;
+            deltaShift += 7;
+            if (deltaShift > 7 * CON_MSG_TIMESTAMP_MAX_LEN)
+            {
+                ReportStreamError("Invalid timestamp, resynchronizing", delta);
+                sequenceValid = false;
+                state = RESYNC;
+            }
+            else if ((data & 0x80) == 0)
+            {
+                deviceTicks += delta;
+                state = RECV;
             }
+            break;
 
+        case RECV:
+            message.messageBytes[byteCount] = data;
+            byteCount++;
             break;
 
         case OUTPUT:
@@ -147,12 +283,34 @@ void ConsoleExpansion_ProcessData(uint8_t data)
             break;
     }
 
+    /* Messages without data are complete once the timestamp is read */
+    if (state == RECV)
+    {
+        ConsoleMessageType type = ConsoleMessage_Type(&message);
+        int length = consoleMessageLength[type];
+        if (byteCount == length)
+        {
+            expander = &expanders[ConsoleMessage_Source(&message)];
+            expander->handler(outString, &message);
+            state = OUTPUT;
+        }
+    }
+
     if (state == OUTPUT)
     {
-        printf("%s.%03ld ", tmbuf, (timeVal.tv_usec/1000));
-        printf("%10s: %s\n", expander->sourceText, outString);
-        fprintf(decode, "%s.%03ld ", tmbuf, (timeVal.tv_usec/1000));
-        fprintf(decode, "%10s: %s\n", expander->sourceText, outString);
+        char line[OUT_LINE_MAX];
+        uint64_t us = deviceTicks * tickPeriod;
+
+        snprintf(line, sizeof(line), "%6lu.%06lu %10s: %s\n", (unsigned long)(us / 1000000),
+                 (unsigned long)(us % 1000000), expander->sourceText, outString);
+        fputs(line, decode);
+        if (echo)
+            fputs(line, stdout);
+        messageCount++;
+
+        ConsoleMessageRecord record = { &message, us, sequence, messagesLost, expander->sourceText, outString };
+        for (int i = 0; i < observerCount; i++)
+            observers[i](&record);
 
         state = IDLE;
     }
@@ -169,6 +327,27 @@ void ConsoleHandler(char* out, ConsoleMessage* message)
             sprintf(out, "%s", "Console started.");
             break;
 
+        case CON_MSG_CONSOLE_DROPPED:
+            sprintf(out, "Marker, messages dropped: %d, lost: %lu", message->data.type16.data1, messagesLost);
+            break;
+
+        case CON_MSG_CONSOLE_TICK_PERIOD:
+            tickPeriod = message->data.type16.data1;
+            sprintf(out, "Timestamp tick period: %dus", tickPeriod);
+            break;
+
+        case CON_MSG_CONSOLE_TICK:
+        {
+            /* Re-anchor on the device's 32 bit tick count, keeping the
+             * wraps already counted */
+            uint64_t ticks = (deviceTicks & ~(uint64_t)UINT32_MAX) | message->data.type32.data1;
+            if (ticks < deviceTicks)
+                ticks += (uint64_t)UINT32_MAX + 1;
+            deviceTicks = ticks;
+            sprintf(out, "Timestamp tick: %lu", (unsigned long)message->data.type32.data1);
+            break;
+        }
+
         default:
             out[0] = 0;
             break;
@@ -14,14 +14,38 @@
 #ifndef CONSOLE_EXPANSION_H_
 #define CONSOLE_EXPANSION_H_
 
+#include <stddef.h>
+
 #include "console.h"
 
+/* Look up a string table entry, guarding against corrupt message data */
+#define CON_EXP_STRING(table, index) \
+    (((size_t)(index) < sizeof(table) / sizeof((table)[0])) ? (table)[(index)] : "Invalid")
+
 typedef void (*ConsoleMessageHandler)(char* out, ConsoleMessage* message);
 
+/* A decoded message as passed to observers */
+typedef struct _ConsoleMessageRecord
+{
+    ConsoleMessage* message;
+    uint64_t timeUs;          /* Device time */
+    uint8_t sequence;
+    unsigned long lost;       /* Messages lost in the stream so far */
+    const char* sourceText;
+    const char* text;         /* Human readable expansion */
+} ConsoleMessageRecord;
+
+/* Invoked for every decoded message */
+typedef void (*ConsoleMessageObserver)(const ConsoleMessageRecord* record);
+
 bool ConsoleExpansion_Init(char* binaryFilename, char* textFilename, char* startupText);
 void ConsoleExpansion_RegisterExpander(ConsoleSource source, ConsoleMessageHandler handler, char* sourceText);
 void ConsoleExpansion_Exit(void);
 void ConsoleExpansion_ProcessData(uint8_t data);
+void ConsoleExpansion_ProcessBuffer(const uint8_t* data, size_t length);
+void ConsoleExpansion_SetEcho(bool enable);
+bool ConsoleExpansion_AddObserver(ConsoleMessageObserver observer);
+unsigned long ConsoleExpansion_MessageCount(void);
 
 
 #endif /* CONSOLE_EXPANSION_H_ */
@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "live_stats.h"
+#include "con_msg_xth_xcvr.h"
+#include "con_msg_xth_kbd.h"
+#include "con_msg_ps2d_kbd.h"
+#include "con_msg_ps2d_xcvr.h"
+
+/* Rates are averaged over a window of one second buckets of device time */
+#define WINDOW_SECONDS 5
+#define US_PER_SECOND 1000000ULL
+
+#define MESSAGE_ID_COUNT 0x100
+#define SOURCE_COUNT 0x10
+
+#define ANSI_HOME_CLEAR "\x1b[H\x1b[2J"
+
+typedef struct _Counter
+{
+    unsigned long total;
+    unsigned long buckets[WINDOW_SECONDS];
+} Counter;
+
+typedef enum _Metric
+{
+    METRIC_XT_SCAN_CODES,
+    METRIC_KEY_EVENTS,
+    METRIC_PS2_BYTES_SENT,
+    METRIC_PS2_BYTES_RECEIVED,
+    METRIC_PS2_RESENDS,
+    METRIC_PS2_XMIT_INTERRUPTED,
+    METRIC_PS2_RECV_ERRORS,
+    METRIC_XT_OVERFLOWS,
+    METRIC_XT_BAD_START_BITS,
+    METRIC_XT_CHATTER,
+    METRIC_COUNT,
+} Metric;
+
+static const char* metricText[METRIC_COUNT] =
+{
+    "XT scan codes",
+    "PS/2 key events",
+    "PS/2 bytes sent",
+    "PS/2 bytes received",
+    "PS/2 resends",
+    "PS/2 transmit interrupted",
+    "PS/2 receive errors",
+    "XT receive overflows",
+    "XT bad start bits",
+    "XT chatter filtered",
+};
+
+static Counter metrics[METRIC_COUNT];
+static Counter messages[SOURCE_COUNT][MESSAGE_ID_COUNT];
+static const char* sourceText[SOURCE_COUNT];
+
+static uint64_t currentSecond;
+static uint64_t lastTimeUs;
+static unsigned long lost;
+static unsigned long messageTotal;
+
+static unsigned refreshPeriodMs;
+static uint64_t lastRenderMs;
+
+static uint64_t HostTimeMs(void)
+{
+#ifdef _WIN32
+    return GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+static void ClearBucket(unsigned bucket)
+{
+    for (int i = 0; i < METRIC_COUNT; i++)
+        metrics[i].buckets[bucket] = 0;
+
+    for (int source = 0; source < SOURCE_COUNT; source++)
+    {
+        for (int id = 0; id < MESSAGE_ID_COUNT; id++)
+            messages[source][id].buckets[bucket] = 0;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ *  Move the window to the second containing timeUs
+ *   - Buckets for skipped seconds are cleared
+ *   - A backwards step (device reset) restarts the window
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void AdvanceWindow(uint64_t timeUs)
+{
+    uint64_t second = timeUs / US_PER_SECOND;
+
+    if (timeUs < lastTimeUs)
+    {
+        for (unsigned bucket = 0; bucket < WINDOW_SECONDS; bucket++)
+            ClearBucket(bucket);
+    }
+    else
+    {
+        uint64_t skipped = second - currentSecond;
+        if (skipped > WINDOW_SECONDS)
+            skipped = WINDOW_SECONDS;
+
+        for (uint64_t i = 1; i <= skipped; i++)
+            ClearBucket((unsigned)((currentSecond + i) % WINDOW_SECONDS));
+    }
+
+    currentSecond = second;
+    lastTimeUs = timeUs;
+}
+
+static void Count(Counter* counter)
+{
+    counter->total++;
+    counter->buckets[currentSecond % WINDOW_SECONDS]++;
+}
+
+static unsigned long WindowCount(const Counter* counter)
+{
+    unsigned long count = 0;
+
+    for (unsigned bucket = 0; bucket < WINDOW_SECONDS; bucket++)
+        count += counter->buckets[bucket];
+
+    return count;
+}
+
+/* Seconds covered by the window, the current second counts as partial */
+static double WindowSeconds(void)
+{
+    uint64_t elapsedUs = lastTimeUs + 1;
+
+    if (elapsedUs > WINDOW_SECONDS * US_PER_SECOND)
+        elapsedUs = (WINDOW_SECONDS - 1) * US_PER_SECOND + lastTimeUs % US_PER_SECOND + 1;
+
+    return (double)elapsedUs / US_PER_SECOND;
+}
+
+/* ------------------------------------------------------------------------
+ *  Map a message onto the headline metric it contributes to
+ *   - Returns METRIC_COUNT if the message is not a headline metric
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static Metric MessageMetric(uint8_t source, uint8_t id)
+{
+    switch (source)
+    {
+        case CON_SRC_XTH_XCVR:
+            if (id == CON_MSG_XTH_XCVR_RECV_SCODE)
+                return METRIC_XT_SCAN_CODES;
+            if (id == CON_MSG_XTH_XCVR_BAD_START_BIT)
+                return METRIC_XT_BAD_START_BITS;
+            break;
+        case CON_SRC_XTH_KBD:
+            if (id == CON_MSG_XTH_KBD_RECV_OVERFLOW)
+                return METRIC_XT_OVERFLOWS;
+            if (id == CON_MSG_XTH_KBD_CHATTER)
+                return METRIC_XT_CHATTER;
+            break;
+        case CON_SRC_PS2D_KBD:
+            if (id == CON_MSG_PS2D_KBD_KEYEVENT)
+                return METRIC_KEY_EVENTS;
+            if (id == CON_MSG_PS2D_KBD_XMIT_INT)
+                return METRIC_PS2_XMIT_INTERRUPTED;
+            break;
+        case CON_SRC_PS2D_XCVR:
+            if (id == CON_MSG_PS2D_XCVR_XMIT)
+                return METRIC_PS2_BYTES_SENT;
+            if (id == CON_MSG_PS2D_XCVR_RECV)
+                return METRIC_PS2_BYTES_RECEIVED;
+            if (id == CON_MSG_PS2D_XCVR_REXMIT)
+                return METRIC_PS2_RESENDS;
+            if (id == CON_MSG_PS2D_XCVR_RECV_ERROR)
+                return METRIC_PS2_RECV_ERRORS;
+            break;
+        default:
+            break;
+    }
+
+    return METRIC_COUNT;
+}
+
+void LiveStats_Init(unsigned refreshMs)
+{
+    memset(metrics, 0, sizeof(metrics));
+    memset(messages, 0, sizeof(messages));
+    memset(sourceText, 0, sizeof(sourceText));
+    currentSecond = 0;
+    lastTimeUs = 0;
+    lost = 0;
+    messageTotal = 0;
+    refreshPeriodMs = refreshMs;
+    lastRenderMs = HostTimeMs();
+}
+
+void LiveStats_Observe(const ConsoleMessageRecord* record)
+{
+    uint8_t source = record->message->sourceType >> 4;
+    uint8_t id = record->message->messageId;
+
+    AdvanceWindow(record->timeUs);
+
+    sourceText[source] = record->sourceText;
+    lost = record->lost;
+    messageTotal++;
+
+    Count(&messages[source][id]);
+
+    Metric metric = MessageMetric(source, id);
+    if (metric != METRIC_COUNT)
+        Count(&metrics[metric]);
+}
+
+void LiveStats_Update(FILE* out)
+{
+    uint64_t now = HostTimeMs();
+
+    if (now - lastRenderMs >= refreshPeriodMs)
+    {
+        lastRenderMs = now;
+        LiveStats_Render(out, true);
+    }
+}
+
+void LiveStats_Render(FILE* out, bool clear)
+{
+    double seconds = WindowSeconds();
+
+    if (clear)
+        fputs(ANSI_HOME_CLEAR, out);
+
+    fprintf(out, "Device time %llu.%03llus  messages %lu  lost %lu  (rates over last %.1fs)\n\n",
+            (unsigned long long)(lastTimeUs / US_PER_SECOND), 
+            (unsigned long long)(lastTimeUs % US_PER_SECOND / 1000),
+            messageTotal, lost, seconds);
+
+    fprintf(out, "%-28s %10s %10s\n", "Metric", "Total", "Per sec");
+    for (int i = 0; i < METRIC_COUNT; i++)
+        fprintf(out, "%-28s %10lu %10.1f\n", metricText[i], metrics[i].total, WindowCount(&metrics[i]) / seconds);
+
+    fprintf(out, "\n%-16s %4s %10s %10s\n", "Source", "Id", "Total", "Per sec");
+    for (int source = 0; source < SOURCE_COUNT; source++)
+    {
+        for (int id = 0; id < MESSAGE_ID_COUNT; id++)
+        {
+            const Counter* counter = &messages[source][id];
+
+            if (counter->total == 0)
+                continue;
+
+            fprintf(out, "%-16s %4d %10lu %10.1f\n", sourceText[source], id, counter->total, WindowCount(counter) / seconds);
+        }
+    }
+
+    fflush(out);
+}
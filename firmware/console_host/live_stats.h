@@ -0,0 +1,18 @@
+#ifndef LIVE_STATS_H_
+#define LIVE_STATS_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "console_expansion.h"
+
+/* Maintains rolling message counters and key rates over the last few
+ * seconds of device time and renders them as a refreshing terminal view.
+ * Register LiveStats_Observe as a message observer and call 
+ * LiveStats_Update from the capture loop. */
+void LiveStats_Init(unsigned refreshMs);
+void LiveStats_Observe(const ConsoleMessageRecord* record);
+void LiveStats_Update(FILE* out);
+void LiveStats_Render(FILE* out, bool clear);
+
+#endif /* LIVE_STATS_H_ */
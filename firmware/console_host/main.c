@@ -3,19 +3,26 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-
+#include <string.h>
+#include <sys/stat.h>
 
+#ifdef _WIN32
 #include <windows.h>
 #include <windef.h>
 #include <winnt.h>
 #include <winbase.h>
 
-#include "ftd2xx.h"
+#include "getopt.h"
+#include "source_ftdi.h"
+#else
+#include <signal.h>
+#include <unistd.h>
 
-#include <string.h>
+#include "source_serial.h"
+#endif
 
-#include "getopt.h"
+#include "source_file.h"
+#include "replay_analysis.h"
 
 #include "console.h"
 #include "console_expansion.h"
@@ -26,10 +33,16 @@
 #include "con_exp_ps2d_xcvr.h"
 #include "con_exp_xt2ps2.h"
 #include "con_exp_keymap.h"
+#include "structured_output.h"
+#include "live_stats.h"
 
 typedef enum _DataSource
 {
+#ifdef _WIN32
     SOURCE_FTDI,
+#else
+    SOURCE_SERIAL,
+#endif
     SOURCE_FILE,
 } DataSource;
 
@@ -39,7 +52,14 @@ typedef struct _Options
     char rawFilename[255];
     char textFilename[255];
     char sourceFilename[255];
+    char deviceFilename[255];
+    char structuredFilename[255];
+    StructuredFormat structuredFormat;
     DataSource dataSource;
+    bool quiet;
+    bool analyze;
+    bool live;
+    bool rawRequested;
 } Options;
 
 
@@ -50,19 +70,42 @@ Options options =
     "out.bin",
     "out.txt",
     "",
-    SOURCE_FTDI
+    "/dev/ttyUSB0",
+    "",
+    STRUCTURED_JSONL,
+#ifdef _WIN32
+    SOURCE_FTDI,
+#else
+    SOURCE_SERIAL,
+#endif
+    false,
+    false,
+    false,
+    false
 };
-FILE* source;
-FT_HANDLE ft_handle;
 
+#define READ_BUFFER_SIZE 4096
+
+#define LIVE_REFRESH_MS 500
+
+static uint8_t readBuffer[READ_BUFFER_SIZE];
+
+/* Cleared by the exit handler to end the capture */
+static volatile bool running = true;
 
+#ifdef _WIN32
 BOOL WINAPI exitHandler(DWORD signal);
+#else
+void exitHandler(int signal);
+#endif
 
-bool FtdiInit(unsigned long baudRate);
-bool SourceFileOpen( char* sourceFilename);
+bool InstallExitHandler(void);
+
+bool SameFile(const char* first, const char* second);
 
 bool DataSourceInit(Options* options);
-bool DataSourceGetNext(uint8_t* data, Options* options);
+size_t DataSourceRead(uint8_t* buffer, size_t size, Options* options);
+bool DataSourceAtEnd(Options* options);
 void DataSourceExit(Options* options);
 
 int main(int argc, char** argv)
@@ -72,7 +115,7 @@ int main(int argc, char** argv)
     int option_index = 0;
 
 
-    while (( option_index = getopt(argc, argv, "u:g")) != -1){
+    while (( option_index = getopt(argc, argv, "b:r:t:s:d:qaj:c:l")) != -1){
 
     switch (option_index)
     {
@@ -80,15 +123,39 @@ int main(int argc, char** argv)
             options.baudRate = atol(optarg);
             break;
         case 'r':
-            strncpy(options.rawFilename, optarg, 255);
+            strncpy(options.rawFilename, optarg, sizeof(options.rawFilename) - 1);
+            options.rawRequested = true;
             break;
         case 't':
-            strncpy(options.textFilename, optarg, 255);
+            strncpy(options.textFilename, optarg, sizeof(options.textFilename) - 1);
             break;
         case 's':
-            strncpy(options.sourceFilename, optarg, 255);
+            strncpy(options.sourceFilename, optarg, sizeof(options.sourceFilename) - 1);
             options.dataSource = SOURCE_FILE;
             break;
+        case 'q':
+            options.quiet = true;
+            break;
+        case 'a':
+            options.analyze = true;
+            break;
+        case 'l':
+            options.live = true;
+            break;
+        case 'j':
+            strncpy(options.structuredFilename, optarg, sizeof(options.structuredFilename) - 1);
+            options.structuredFormat = STRUCTURED_JSONL;
+            break;
+        case 'c':
+            strncpy(options.structuredFilename, optarg, sizeof(options.structuredFilename) - 1);
+            options.structuredFormat = STRUCTURED_CSV;
+            break;
+#ifndef _WIN32
+        case 'd':
+            strncpy(options.deviceFilename, optarg, sizeof(options.deviceFilename) - 1);
+            options.dataSource = SOURCE_SERIAL;
+            break;
+#endif
         default:
             fprintf(stderr, "Invalid option '%c'\n", option_index);
             return 1;
@@ -96,17 +163,31 @@ int main(int argc, char** argv)
     }  //end block for while
 
 
-    if (!SetConsoleCtrlHandler(exitHandler, TRUE)) {
+    if (!InstallExitHandler()) {
         fprintf(stderr, "\nERROR: Could not set exit handler");
         return 1;
     }
 
 
-    if (!ConsoleExpansion_Init(options.rawFilename, options.textFilename, "XT2PS2 Console Host"))
+    /*
+     * Open the source before any output is created, a replay must never
+     * truncate the capture it is reading. Raw output is only written for a
+     * replay when explicitly requested.
+     */
+    char* rawFilename = options.rawFilename;
+
+    if (options.dataSource == SOURCE_FILE)
     {
-        return 1;
-    }
+        if (!options.rawRequested)
+            rawFilename = NULL;
 
+        if ((rawFilename != NULL && SameFile(rawFilename, options.sourceFilename)) ||
+            SameFile(options.textFilename, options.sourceFilename))
+        {
+            fprintf(stderr, "ERROR: Output file would overwrite the source '%s'\n", options.sourceFilename);
+            return 1;
+        }
+    }
 
     bool initSuccess = DataSourceInit(&options);
 
@@ -115,6 +196,35 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (!ConsoleExpansion_Init(rawFilename, options.textFilename, "XT2PS2 Console Host"))
+    {
+        DataSourceExit(&options);
+        return 1;
+    }
+
+
+    /* The live view replaces the scrolling text */
+    ConsoleExpansion_SetEcho(!options.quiet && !options.live);
+
+    if (options.analyze)
+    {
+        ReplayAnalysis_Init();
+        ConsoleExpansion_AddObserver(ReplayAnalysis_Observe);
+    }
+
+    if (options.live)
+    {
+        LiveStats_Init(LIVE_REFRESH_MS);
+        ConsoleExpansion_AddObserver(LiveStats_Observe);
+    }
+
+    if (options.structuredFilename[0] != '\0')
+    {
+        if (!StructuredOutput_Open(options.structuredFilename, options.structuredFormat))
+            return 1;
+        ConsoleExpansion_AddObserver(StructuredOutput_Observe);
+    }
+
     ConsoleExpansion_RegisterExpander(CON_SRC_TEST, testConsoleHandler, testSourceText);
     ConsoleExpansion_RegisterExpander(CON_SRC_XTH_XCVR, xthXcvrConsoleHandler, xthXcvrSourceText);
     ConsoleExpansion_RegisterExpander(CON_SRC_XTH_KBD, xthKbdConsoleHandler, xthKbdSourceText);
@@ -123,128 +233,79 @@ int main(int argc, char** argv)
     ConsoleExpansion_RegisterExpander(CON_SRC_XT2PS2, xt2Ps2ConsoleHandler, xt2Ps2SourceText);
     ConsoleExpansion_RegisterExpander(CON_SRC_KEYMAP, keymapConsoleHandler, keymapSourceText);
 
-    while (1)
+    while (running)
     {
-        uint8_t data;
-        if (DataSourceGetNext(&data, &options))
+        size_t count = DataSourceRead(readBuffer, sizeof(readBuffer), &options);
+        if (count > 0)
         {
-            ConsoleExpansion_ProcessData(data);
+            ConsoleExpansion_ProcessBuffer(readBuffer, count);
+        }
+        else if (DataSourceAtEnd(&options))
+        {
+            break;
         }
 
+        if (options.live)
+            LiveStats_Update(stdout);
     }
 
     ConsoleExpansion_Exit();
+    DataSourceExit(&options);
 
-    return 0;
-}
-
-
-
-bool FtdiInit(unsigned long baudRate)
-{
-    LONG comPortNumber;
-    FT_STATUS ft_status;
-
-    ft_status = FT_Open(0,&ft_handle);
-
-    if (ft_status != FT_OK)
-    {
-        fprintf(stderr, "No FTDI serial port detected");
-        return false;
-    }
-
-    ft_status = FT_GetComPortNumber(ft_handle, &comPortNumber);
-
-    FT_SetBaudRate(ft_handle, baudRate);
-
-    FT_SetDataCharacteristics(ft_handle,       // Handle of the chip(FT232)
-                              FT_BITS_8,       // No of Data bits = 8
-                              FT_STOP_BITS_1,  // No of Stop Bits = 1
-                              FT_PARITY_NONE   // Parity = NONE
-                              );
+    if (options.structuredFilename[0] != '\0')
+        StructuredOutput_Close();
 
-    FT_SetFlowControl(ft_handle, FT_FLOW_NONE, 0, 0);
+    if (options.live)
+        LiveStats_Render(stdout, true);
 
-    FT_Purge(ft_handle, FT_PURGE_RX | FT_PURGE_TX);
+    if (options.analyze)
+        ReplayAnalysis_Report(stdout);
 
-    printf("Connected to FTDI serial converter on COM%ld\n", comPortNumber);
-    printf("Ready..\n");
     printf("\n");
+    printf("Exiting...\n");
 
-    return true;
-}
-
-
-
-bool SourceFileOpen( char* sourceFilename)
-{
-    source = fopen(sourceFilename, "r");
-    if (source == NULL)
-    {
-        fprintf(stderr, "Unable to open file to read source data: %s", sourceFilename);
-        return false;
-    }
-
-    return true;
+    return 0;
 }
 
 
-bool FtdiRead(uint8_t* data)
+bool SameFile(const char* first, const char* second)
 {
-    DWORD bytesToRead;
-    unsigned char byteRead;
-    DWORD bytesRead;
+#ifdef _WIN32
+    char firstPath[_MAX_PATH];
+    char secondPath[_MAX_PATH];
 
-    FT_STATUS ft_status;
-
-    ft_status = FT_GetQueueStatus(ft_handle, &bytesToRead);
-    if (ft_status == FT_OK && bytesToRead > 0)
-    {
-        ft_status = FT_Read(ft_handle, &byteRead, 1, &bytesRead );
-        if (ft_status != FT_OK)
-        {
-            fprintf(stderr, "Failure reading from FTDI");
-            return false;
-        }
-        else
-        {
-            *data = byteRead;
-        }
-    }
-    else
-    {
+    if (_fullpath(firstPath, first, sizeof(firstPath)) == NULL ||
+        _fullpath(secondPath, second, sizeof(secondPath)) == NULL)
         return false;
-    }
 
+    return _stricmp(firstPath, secondPath) == 0;
+#else
+    struct stat firstStat;
+    struct stat secondStat;
 
-    return true;
-}
-
-bool SourceFileRead(uint8_t* data)
-{
-    size_t bytesRead;
-
-    bytesRead = fread(&data, 1, 1, source);
-
-    if (bytesRead < 1)
-    {
-        fprintf(stderr, "Failure reading from source file");
+    /* An output that does not exist yet cannot be the source */
+    if (stat(first, &firstStat) != 0 || stat(second, &secondStat) != 0)
         return false;
-    }
 
-    return data;
+    return (firstStat.st_dev == secondStat.st_dev) && (firstStat.st_ino == secondStat.st_ino);
+#endif
 }
 
-
 bool DataSourceInit(Options* options)
 {
     bool result = false;
 
     switch (options->dataSource)
     {
+#ifdef _WIN32
         case SOURCE_FTDI:
             result = FtdiInit(options->baudRate);
             break;
+#else
+        case SOURCE_SERIAL:
+            result = SerialOpen(options->deviceFilename, options->baudRate);
+            break;
+#endif
         case SOURCE_FILE:
             result = SourceFileOpen(options->sourceFilename);
             break;
@@ -252,16 +313,44 @@ bool DataSourceInit(Options* options)
     return result;
 }
 
-bool DataSourceGetNext(uint8_t* data, Options* options)
+size_t DataSourceRead(uint8_t* buffer, size_t size, Options* options)
 {
-    bool result;
+    size_t result = 0;
     switch (options->dataSource)
     {
+#ifdef _WIN32
         case SOURCE_FTDI:
-            result = FtdiRead(data);
+            result = FtdiRead(buffer, size);
             break;
+#else
+        case SOURCE_SERIAL:
+            result = SerialRead(buffer, size);
+            break;
+#endif
+        case SOURCE_FILE:
+            result = SourceFileRead(buffer, size);
+            break;
+    }
+
+    return result;
+}
+
+bool DataSourceAtEnd(Options* options)
+{
+    bool result = false;
+    switch (options->dataSource)
+    {
+#ifdef _WIN32
+        case SOURCE_FTDI:
+            result = false;
+            break;
+#else
+        case SOURCE_SERIAL:
+            result = SerialAtEnd();
+            break;
+#endif
         case SOURCE_FILE:
-            result = SourceFileRead(data);
+            result = SourceFileAtEnd();
             break;
     }
 
@@ -272,23 +361,50 @@ void DataSourceExit(Options* options)
 {
     switch (options->dataSource)
     {
+#ifdef _WIN32
         case SOURCE_FTDI:
-            FT_Close(ft_handle);
+            FtdiExit();
             break;
+#else
+        case SOURCE_SERIAL:
+            SerialClose();
+            break;
+#endif
         case SOURCE_FILE:
-            fclose(source);
+            SourceFileClose();
             break;
     }
 
 }
 
+#ifdef _WIN32
+bool InstallExitHandler(void)
+{
+    return SetConsoleCtrlHandler(exitHandler, TRUE);
+}
+
 BOOL WINAPI exitHandler(DWORD signal)
 {
-    ConsoleExpansion_Exit();
-    DataSourceExit(&options);
+    running = false;
 
-    printf("\n");
-    printf("Exiting...\n");
+    return TRUE;
+}
+#else
+bool InstallExitHandler(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = exitHandler;
+    sigemptyset(&action.sa_mask);
 
-    return FALSE;
+    return (sigaction(SIGINT, &action, NULL) == 0) &&
+           (sigaction(SIGTERM, &action, NULL) == 0);
+}
+
+void exitHandler(int signal)
+{
+    (void)signal;
+    running = false;
 }
+#endif
@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "replay_analysis.h"
+#include "con_msg_xth_xcvr.h"
+#include "con_msg_xth_kbd.h"
+#include "con_msg_xt2ps2.h"
+#include "con_msg_ps2d_kbd.h"
+#include "con_msg_ps2d_xcvr.h"
+#include "ps2_command.h"
+
+/* Key events still waiting for a later pipeline stage */
+#define PENDING_MAX 32
+
+/* Pending events older than this are abandoned, e.g. the last keys of a
+ * capture that never reached a later stage */
+#define PENDING_TIMEOUT_US 500000ULL
+
+#define XT_CODE_COUNT 0x80
+#define KEY_CODE_COUNT 0x100
+
+#define NO_TIME UINT64_MAX
+
+typedef enum _Stage
+{
+    STAGE_XT_TO_MAPPED,
+    STAGE_MAPPED_TO_EVENT,
+    STAGE_EVENT_TO_WIRE,
+    STAGE_XT_TO_WIRE,
+    STAGE_COUNT,
+} Stage;
+
+static const char* stageText[STAGE_COUNT] =
+{
+    "XT receive -> keymap",
+    "Keymap -> PS/2 key event",
+    "PS/2 key event -> first byte sent",
+    "XT receive -> first byte sent",
+};
+
+/* Histogram bucket upper bounds in microseconds, the last bucket is open */
+#define LIMIT_COUNT 8
+#define BUCKET_COUNT (LIMIT_COUNT + 1)
+
+static const uint32_t latencyLimits[LIMIT_COUNT] = 
+    { 250, 500, 1000, 2000, 5000, 10000, 20000, 50000 };
+static const uint32_t typematicLimits[LIMIT_COUNT] = 
+    { 40000, 70000, 100000, 150000, 250000, 500000, 750000, 1000000 };
+
+typedef struct _Histogram
+{
+    const uint32_t* limits;
+    unsigned long count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    unsigned long buckets[BUCKET_COUNT];
+} Histogram;
+
+typedef struct _PendingEvent
+{
+    uint8_t xtCode;
+    uint64_t xtTime;
+    uint64_t mappedTime;
+    uint64_t eventTime;
+    uint8_t wireLength;       /* Bytes sent for the key event */
+    uint8_t wireFirst;        /* First byte sent for the key event */
+} PendingEvent;
+
+typedef struct _Typematic
+{
+    bool active;
+    uint8_t key;
+    int repeatByte;           /* -1 until the first repeat is seen */
+    uint64_t lastRepeat;
+    unsigned long bursts;
+    unsigned long repeats;
+    Histogram delay;          /* Key press to first repeat */
+    Histogram interval;       /* Between repeats */
+    double intervalSquares;   /* For the interval standard deviation */
+} Typematic;
+
+static PendingEvent pending[PENDING_MAX];
+static int pendingCount;
+
+static Histogram stageTotals[STAGE_COUNT];
+static Histogram keyXtToWire[XT_CODE_COUNT];
+
+static uint64_t keyPressTime[KEY_CODE_COUNT];
+static uint64_t lastReceiveTime;
+static Typematic typematic;
+
+static unsigned long unmatched;
+
+static void HistogramAdd(Histogram* histogram, uint64_t value)
+{
+    size_t bucket = 0;
+
+    while (bucket < LIMIT_COUNT && value >= histogram->limits[bucket])
+        bucket++;
+
+    if (histogram->count == 0 || value < histogram->min)
+        histogram->min = value;
+    if (value > histogram->max)
+        histogram->max = value;
+
+    histogram->count++;
+    histogram->sum += value;
+    histogram->buckets[bucket]++;
+}
+
+static void PendingRemove(int index)
+{
+    memmove(&pending[index], &pending[index + 1], (pendingCount - index - 1) * sizeof(PendingEvent));
+    pendingCount--;
+}
+
+/* ------------------------------------------------------------------------
+ *  Abandon pending events that never reached a later stage
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void PendingExpire(uint64_t timeUs)
+{
+    while (pendingCount > 0 && timeUs - pending[0].xtTime > PENDING_TIMEOUT_US)
+    {
+        PendingRemove(0);
+        unmatched++;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ *  Starts tracking a scan code accepted by the XT keyboard. Prefixes,
+ *  keyboard repeats and debounced codes are never accepted, the latency
+ *  is measured from the receipt of the byte completing the scan code.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void OnXtScanCode(uint8_t code)
+{
+    if (pendingCount == PENDING_MAX)
+    {
+        PendingRemove(0);
+        unmatched++;
+    }
+
+    pending[pendingCount].xtCode = code;
+    pending[pendingCount].xtTime = lastReceiveTime;
+    pending[pendingCount].mappedTime = NO_TIME;
+    pending[pendingCount].eventTime = NO_TIME;
+    pendingCount++;
+}
+
+/* ------------------------------------------------------------------------
+ *  Pairs a mapped key with the oldest pending scan code for the same key.
+ *  Scan codes are mapped in order, older codes still waiting for the
+ *  keymap or for their key event were dropped and are abandoned.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void OnKeyMapped(uint8_t xtCode, uint64_t timeUs)
+{
+    int i = 0;
+
+    while (i < pendingCount && (pending[i].mappedTime != NO_TIME || (pending[i].xtCode & 0x7F) != xtCode))
+        i++;
+
+    if (i == pendingCount)
+        return;
+
+    pending[i].mappedTime = timeUs;
+    HistogramAdd(&stageTotals[STAGE_XT_TO_MAPPED], timeUs - pending[i].xtTime);
+
+    while (i-- > 0)
+    {
+        if (pending[i].eventTime == NO_TIME)
+        {
+            PendingRemove(i);
+            unmatched++;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------
+ *  Pairs a key event with the oldest mapped scan code. Events sending no
+ *  bytes, e.g. Pause releases and keys disabled by the host, complete 
+ *  here, others wait for their first byte on the wire.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void OnKeyEvent(uint8_t key, bool press, uint8_t wireLength, uint8_t wireFirst, uint64_t timeUs)
+{
+    if (press)
+    {
+        keyPressTime[key] = timeUs;
+
+        /* A new key press ends typematic repeat of the previous key */
+        typematic.active = false;
+    }
+    else if (key == typematic.key)
+    {
+        typematic.active = false;
+    }
+
+    for (int i = 0; i < pendingCount; i++)
+    {
+        if (pending[i].mappedTime != NO_TIME && pending[i].eventTime == NO_TIME)
+        {
+            HistogramAdd(&stageTotals[STAGE_MAPPED_TO_EVENT], timeUs - pending[i].mappedTime);
+            if (wireLength == 0)
+            {
+                PendingRemove(i);
+                return;
+            }
+            pending[i].eventTime = timeUs;
+            pending[i].wireLength = wireLength;
+            pending[i].wireFirst = wireFirst;
+            return;
+        }
+    }
+}
+
+static bool IsResponse(uint8_t data)
+{
+    return data == PS2_RESP_ACK || data == PS2_RESP_RESEND || data == PS2_RESP_ECHO ||
+           data == PS2_RESP_SELF_TEST_OK || data == PS2_RESP_SELF_TEST_FAILED;
+}
+
+static bool IsPrefix(uint8_t data)
+{
+    return data == 0xE0 || data == 0xE1 || data == 0xF0;
+}
+
+/* Returns true if the byte is a typematic repeat */
+static bool OnTypematicByte(uint8_t data, uint64_t timeUs)
+{
+    if (!typematic.active)
+        return false;
+
+    if (typematic.repeatByte < 0)
+    {
+        /* First repeat follows the typematic delay */
+        typematic.repeatByte = data;
+        if (keyPressTime[typematic.key] != NO_TIME)
+            HistogramAdd(&typematic.delay, timeUs - keyPressTime[typematic.key]);
+    }
+    else if (data == typematic.repeatByte)
+    {
+        uint64_t interval = timeUs - typematic.lastRepeat;
+        HistogramAdd(&typematic.interval, interval);
+        typematic.intervalSquares += (double)interval * interval;
+    }
+    else
+    {
+        return false;
+    }
+
+    typematic.repeats++;
+    typematic.lastRepeat = timeUs;
+    return true;
+}
+
+/* ------------------------------------------------------------------------
+ *  Pairs the first byte of a sequence with the oldest key event sending
+ *  it. Older events still waiting never reached the wire, e.g. bytes 
+ *  discarded by the device, and are abandoned.
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static void OnWireByte(uint8_t data, uint64_t timeUs)
+{
+    static bool afterPrefix = false;
+    static int remaining = 0;
+    bool sequenceStart;
+    int i = 0;
+
+    if (IsResponse(data))
+        return;
+
+    /* Bytes of a matched sequence are skipped by count, bytes following
+     * a prefix continue a typematic sequence */
+    if (remaining > 0)
+    {
+        remaining--;
+        return;
+    }
+
+    sequenceStart = !afterPrefix;
+    afterPrefix = IsPrefix(data);
+
+    if (!sequenceStart || OnTypematicByte(data, timeUs))
+        return;
+
+    while (i < pendingCount && (pending[i].eventTime == NO_TIME || pending[i].wireFirst != data))
+        i++;
+
+    if (i == pendingCount)
+        return;
+
+    HistogramAdd(&stageTotals[STAGE_EVENT_TO_WIRE], timeUs - pending[i].eventTime);
+    HistogramAdd(&stageTotals[STAGE_XT_TO_WIRE], timeUs - pending[i].xtTime);
+    HistogramAdd(&keyXtToWire[pending[i].xtCode & 0x7F], timeUs - pending[i].xtTime);
+    remaining = pending[i].wireLength - 1;
+    afterPrefix = false;
+    PendingRemove(i);
+
+    while (i-- > 0)
+    {
+        if (pending[i].eventTime != NO_TIME)
+        {
+            PendingRemove(i);
+            unmatched++;
+        }
+    }
+}
+
+void ReplayAnalysis_Init(void)
+{
+    memset(pending, 0, sizeof(pending));
+    pendingCount = 0;
+    memset(stageTotals, 0, sizeof(stageTotals));
+    memset(keyXtToWire, 0, sizeof(keyXtToWire));
+    memset(&typematic, 0, sizeof(typematic));
+
+    for (int i = 0; i < STAGE_COUNT; i++)
+        stageTotals[i].limits = latencyLimits;
+    for (int i = 0; i < XT_CODE_COUNT; i++)
+        keyXtToWire[i].limits = latencyLimits;
+    typematic.delay.limits = typematicLimits;
+    typematic.interval.limits = typematicLimits;
+    for (int i = 0; i < KEY_CODE_COUNT; i++)
+        keyPressTime[i] = NO_TIME;
+    lastReceiveTime = 0;
+    unmatched = 0;
+}
+
+void ReplayAnalysis_Observe(const ConsoleMessageRecord* record)
+{
+    ConsoleMessage* message = record->message;
+    uint64_t timeUs = record->timeUs;
+
+    PendingExpire(timeUs);
+
+    switch (ConsoleMessage_Source(message))
+    {
+        case CON_SRC_XTH_XCVR:
+            if (message->messageId == CON_MSG_XTH_XCVR_RECV_SCODE)
+                lastReceiveTime = timeUs;
+            break;
+
+        case CON_SRC_XTH_KBD:
+            if (message->messageId == CON_MSG_XTH_KBD_SCAN_CODE)
+                OnXtScanCode(message->data.type8.data1);
+            break;
+
+        case CON_SRC_XT2PS2:
+            if (message->messageId == CON_MSG_XT2PS2_KEYMAPPED)
+                OnKeyMapped(message->data.type88.data1, timeUs);
+            break;
+
+        case CON_SRC_PS2D_KBD:
+            switch (message->messageId)
+            {
+                case CON_MSG_PS2D_KBD_KEYEVENT:
+                    OnKeyEvent(message->data.type8888.data1, message->data.type8888.data2 != 0,
+                               message->data.type8888.data3, message->data.type8888.data4, timeUs);
+                    break;
+
+                case CON_MSG_PS2D_KBD_TM_ACTIVE:
+                    if (!typematic.active)
+                        typematic.bursts++;
+                    typematic.active = true;
+                    typematic.key = message->data.type8.data1;
+                    typematic.repeatByte = -1;
+                    break;
+
+                case CON_MSG_PS2D_KBD_TM_INACTIVE:
+                    typematic.active = false;
+                    break;
+            }
+            break;
+
+        case CON_SRC_PS2D_XCVR:
+            if (message->messageId == CON_MSG_PS2D_XCVR_XMIT)
+                OnWireByte(message->data.type8.data1, timeUs);
+            break;
+    }
+}
+
+static void HistogramReport(FILE* out, const Histogram* histogram)
+{
+    unsigned long peak = 0;
+
+    fprintf(out, "    count %lu, min %llu us, avg %llu us, max %llu us\n", histogram->count,
+            (unsigned long long)histogram->min, (unsigned long long)(histogram->sum / histogram->count),
+            (unsigned long long)histogram->max);
+
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+        if (histogram->buckets[i] > peak)
+            peak = histogram->buckets[i];
+
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        char label[24];
+        int bar = (int)((histogram->buckets[i] * 40 + peak - 1) / peak);
+
+        if (i < LIMIT_COUNT)
+            snprintf(label, sizeof(label), "< %lu us", (unsigned long)histogram->limits[i]);
+        else
+            snprintf(label, sizeof(label), ">= %lu us", (unsigned long)histogram->limits[i - 1]);
+
+        fprintf(out, "    %13s %8lu %.*s\n", label, histogram->buckets[i], bar,
+                "########################################");
+    }
+}
+
+void ReplayAnalysis_Report(FILE* out)
+{
+    fprintf(out, "\n==== Key event latency ====\n");
+
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        fprintf(out, "\n  %s\n", stageText[stage]);
+        if (stageTotals[stage].count > 0)
+            HistogramReport(out, &stageTotals[stage]);
+        else
+            fprintf(out, "    no samples\n");
+    }
+
+    fprintf(out, "\n  Unmatched key events: %lu\n", unmatched);
+
+    fprintf(out, "\n==== Per key latency, XT receive -> first byte sent ====\n");
+
+    for (int code = 0; code < XT_CODE_COUNT; code++)
+    {
+        if (keyXtToWire[code].count == 0)
+            continue;
+
+        fprintf(out, "\n  XT scan code %02X\n", code);
+        HistogramReport(out, &keyXtToWire[code]);
+    }
+
+    fprintf(out, "\n==== Typematic ====\n");
+    fprintf(out, "\n  Bursts %lu, repeats %lu\n", typematic.bursts, typematic.repeats);
+
+    if (typematic.delay.count > 0)
+    {
+        fprintf(out, "\n  Delay, key press -> first repeat\n");
+        HistogramReport(out, &typematic.delay);
+    }
+
+    if (typematic.interval.count > 0)
+    {
+        double mean = (double)typematic.interval.sum / typematic.interval.count;
+        double variance = typematic.intervalSquares / typematic.interval.count - mean * mean;
+
+        fprintf(out, "\n  Repeat interval\n");
+        HistogramReport(out, &typematic.interval);
+        fprintf(out, "    rate %.2f cps, interval std dev %.0f us\n", 1000000.0 / mean,
+                variance > 0 ? sqrt(variance) : 0.0);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef REPLAY_ANALYSIS_H_
+#define REPLAY_ANALYSIS_H_
+
+#include <stdio.h>
+
+#include "console_expansion.h"
+
+/* Reconstructs the XT -> keymap -> PS/2 key event timeline from decoded
+ * messages and reports per key latency histograms and typematic 
+ * statistics. Register ReplayAnalysis_Observe as a message observer. */
+void ReplayAnalysis_Init(void);
+void ReplayAnalysis_Observe(const ConsoleMessageRecord* record);
+void ReplayAnalysis_Report(FILE* out);
+
+#endif /* REPLAY_ANALYSIS_H_ */
@@ -0,0 +1,37 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "source_serial.h"
+
+#ifdef __linux__
+
+/* termios2 is kept out of source_serial.c, its definitions clash with
+ * <termios.h> */
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+
+bool SerialSetCustomBaud(int fd, unsigned long baudRate)
+{
+    struct termios2 tty;
+
+    if (ioctl(fd, TCGETS2, &tty) != 0)
+        return false;
+
+    tty.c_cflag &= ~CBAUD;
+    tty.c_cflag |= BOTHER;
+    tty.c_ispeed = baudRate;
+    tty.c_ospeed = baudRate;
+
+    return ioctl(fd, TCSETS2, &tty) == 0;
+}
+
+#else
+
+bool SerialSetCustomBaud(int fd, unsigned long baudRate)
+{
+    (void)fd;
+    (void)baudRate;
+    return false;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "source_file.h"
+
+static FILE* source = NULL;
+
+bool SourceFileOpen(const char* sourceFilename)
+{
+    if (strcmp(sourceFilename, "-") == 0)
+    {
+        source = stdin;
+        return true;
+    }
+
+    source = fopen(sourceFilename, "rb");
+    if (source == NULL)
+    {
+        fprintf(stderr, "Unable to open file to read source data: %s\n", sourceFilename);
+        return false;
+    }
+
+    setvbuf(source, NULL, _IONBF, 0);
+
+    return true;
+}
+
+size_t SourceFileRead(uint8_t* buffer, size_t size)
+{
+    size_t bytesRead = fread(buffer, 1, size, source);
+
+    if (bytesRead < size && ferror(source))
+        fprintf(stderr, "Failure reading from source file\n");
+
+    return bytesRead;
+}
+
+bool SourceFileAtEnd(void)
+{
+    return feof(source) || ferror(source);
+}
+
+void SourceFileClose(void)
+{
+    if (source != NULL && source != stdin)
+        fclose(source);
+    source = NULL;
+}
@@ -0,0 +1,15 @@
+#ifndef SOURCE_FILE_H_
+#define SOURCE_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* File data source, a filename of "-" reads standard input so captures
+ * can be piped in */
+bool SourceFileOpen(const char* sourceFilename);
+size_t SourceFileRead(uint8_t* buffer, size_t size);
+bool SourceFileAtEnd(void);
+void SourceFileClose(void);
+
+#endif /* SOURCE_FILE_H_ */
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <windows.h>
+#include <windef.h>
+#include <winnt.h>
+#include <winbase.h>
+
+#include "ftd2xx.h"
+
+#include "source_ftdi.h"
+
+static FT_HANDLE ft_handle;
+
+bool FtdiInit(unsigned long baudRate)
+{
+    LONG comPortNumber;
+    FT_STATUS ft_status;
+
+    ft_status = FT_Open(0,&ft_handle);
+
+    if (ft_status != FT_OK)
+    {
+        fprintf(stderr, "No FTDI serial port detected");
+        return false;
+    }
+
+    ft_status = FT_GetComPortNumber(ft_handle, &comPortNumber);
+
+    FT_SetBaudRate(ft_handle, baudRate);
+
+    FT_SetDataCharacteristics(ft_handle,       // Handle of the chip(FT232)
+                              FT_BITS_8,       // No of Data bits = 8
+                              FT_STOP_BITS_1,  // No of Stop Bits = 1
+                              FT_PARITY_NONE   // Parity = NONE
+                              );
+
+    FT_SetFlowControl(ft_handle, FT_FLOW_NONE, 0, 0);
+
+    FT_Purge(ft_handle, FT_PURGE_RX | FT_PURGE_TX);
+
+    printf("Connected to FTDI serial converter on COM%ld\n", comPortNumber);
+    printf("Ready..\n");
+    printf("\n");
+
+    return true;
+}
+
+size_t FtdiRead(uint8_t* buffer, size_t size)
+{
+    DWORD bytesToRead;
+    DWORD bytesRead = 0;
+
+    FT_STATUS ft_status;
+
+    ft_status = FT_GetQueueStatus(ft_handle, &bytesToRead);
+    if (ft_status == FT_OK && bytesToRead > 0)
+    {
+        if (bytesToRead > size)
+            bytesToRead = (DWORD)size;
+
+        ft_status = FT_Read(ft_handle, buffer, bytesToRead, &bytesRead);
+        if (ft_status != FT_OK)
+        {
+            fprintf(stderr, "Failure reading from FTDI");
+            return 0;
+        }
+    }
+
+    return bytesRead;
+}
+
+void FtdiExit(void)
+{
+    FT_Close(ft_handle);
+}
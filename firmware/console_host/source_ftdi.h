@@ -0,0 +1,13 @@
+#ifndef SOURCE_FTDI_H_
+#define SOURCE_FTDI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* FTDI D2XX data source, Windows only */
+bool FtdiInit(unsigned long baudRate);
+size_t FtdiRead(uint8_t* buffer, size_t size);
+void FtdiExit(void);
+
+#endif /* SOURCE_FTDI_H_ */
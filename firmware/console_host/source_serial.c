@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "source_serial.h"
+
+static int fd = -1;
+static bool atEnd = false;
+
+typedef struct _BaudRate
+{
+    unsigned long rate;
+    speed_t speed;
+} BaudRate;
+
+static const BaudRate baudRates[] =
+{
+    { 9600, B9600 },
+    { 19200, B19200 },
+    { 38400, B38400 },
+    { 57600, B57600 },
+    { 115200, B115200 },
+    { 230400, B230400 },
+};
+
+bool SerialOpen(const char* device, unsigned long baudRate)
+{
+    struct termios tty;
+    speed_t speed = 0;
+
+    fd = open(device, O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Unable to open serial device %s: %s\n", device, strerror(errno));
+        return false;
+    }
+
+    if (tcgetattr(fd, &tty) != 0)
+    {
+        fprintf(stderr, "Unable to read serial settings: %s\n", strerror(errno));
+        SerialClose();
+        return false;
+    }
+
+    /* Raw 8N1, no flow control */
+    cfmakeraw(&tty);
+    tty.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tty.c_cflag |= CS8 | CLOCAL | CREAD;
+    tty.c_iflag &= ~(IXON | IXOFF | IXANY);
+
+    /* Return after 100ms without data so an exit request is noticed */
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 1;
+
+    for (size_t i = 0; i < sizeof(baudRates) / sizeof(baudRates[0]); i++)
+    {
+        if (baudRates[i].rate == baudRate)
+            speed = baudRates[i].speed;
+    }
+
+    if (speed != 0)
+    {
+        cfsetispeed(&tty, speed);
+        cfsetospeed(&tty, speed);
+    }
+
+    if (tcsetattr(fd, TCSANOW, &tty) != 0)
+    {
+        fprintf(stderr, "Unable to apply serial settings: %s\n", strerror(errno));
+        SerialClose();
+        return false;
+    }
+
+    if (speed == 0 && !SerialSetCustomBaud(fd, baudRate))
+    {
+        fprintf(stderr, "Unsupported baud rate: %lu\n", baudRate);
+        SerialClose();
+        return false;
+    }
+
+    tcflush(fd, TCIFLUSH);
+    atEnd = false;
+
+    printf("Connected to %s at %lu baud\n", device, baudRate);
+    printf("Ready..\n");
+    printf("\n");
+
+    return true;
+}
+
+size_t SerialRead(uint8_t* buffer, size_t size)
+{
+    ssize_t bytesRead = read(fd, buffer, size);
+
+    if (bytesRead > 0)
+        return (size_t)bytesRead;
+
+    if (bytesRead < 0 && errno != EINTR && errno != EAGAIN)
+    {
+        /* Device removed or pseudo-terminal closed */
+        fprintf(stderr, "Failure reading from serial device: %s\n", strerror(errno));
+        atEnd = true;
+    }
+
+    return 0;
+}
+
+bool SerialAtEnd(void)
+{
+    return atEnd;
+}
+
+void SerialClose(void)
+{
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+}
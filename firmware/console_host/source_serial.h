@@ -0,0 +1,19 @@
+#ifndef SOURCE_SERIAL_H_
+#define SOURCE_SERIAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* POSIX termios serial data source. Any tty device can be used, e.g. an
+ * FTDI converter bound to /dev/ttyUSB0 or a pseudo-terminal. */
+bool SerialOpen(const char* device, unsigned long baudRate);
+size_t SerialRead(uint8_t* buffer, size_t size);
+bool SerialAtEnd(void);
+void SerialClose(void);
+
+/* Set a baud rate that has no Bxxxx constant, returns false if the
+ * platform does not support arbitrary rates */
+bool SerialSetCustomBaud(int fd, unsigned long baudRate);
+
+#endif /* SOURCE_SERIAL_H_ */
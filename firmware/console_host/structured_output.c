@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "structured_output.h"
+
+#define FILE_BUFFER_SIZE (64 * 1024)
+#define FIELD_MAX 4
+
+static FILE* out = NULL;
+static StructuredFormat outFormat;
+
+static const char* typeText[CON_MSG_COUNT] =
+{
+    "DATA0", "DATA8", "DATA88", "DATA888", "DATA8888",
+    "DATA16", "DATA1616", "DATA32", "DATA816", "DATA8816",
+};
+
+/* ------------------------------------------------------------------------
+ *  Extract the typed data fields of a message in declaration order
+ *   - Returns the number of fields
+ * . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . */
+static int MessageFields(const ConsoleMessage* message, uint32_t* fields)
+{
+    const ConsoleMessageData* data = &message->data;
+
+    switch (message->sourceType & 0x0F)
+    {
+        case CON_MSG_DATA8:
+            fields[0] = data->type8.data1;
+            return 1;
+        case CON_MSG_DATA88:
+            fields[0] = data->type88.data1;
+            fields[1] = data->type88.data2;
+            return 2;
+        case CON_MSG_DATA888:
+            fields[0] = data->type888.data1;
+            fields[1] = data->type888.data2;
+            fields[2] = data->type888.data3;
+            return 3;
+        case CON_MSG_DATA8888:
+            fields[0] = data->type8888.data1;
+            fields[1] = data->type8888.data2;
+            fields[2] = data->type8888.data3;
+            fields[3] = data->type8888.data4;
+            return 4;
+        case CON_MSG_DATA16:
+            fields[0] = data->type16.data1;
+            return 1;
+        case CON_MSG_DATA1616:
+            fields[0] = data->type1616.data1;
+            fields[1] = data->type1616.data2;
+            return 2;
+        case CON_MSG_DATA32:
+            fields[0] = data->type32.data1;
+            return 1;
+        case CON_MSG_DATA816:
+            fields[0] = data->type816.data1;
+            fields[1] = data->type816.data2;
+            return 2;
+        case CON_MSG_DATA8816:
+            fields[0] = data->type8816.data1;
+            fields[1] = data->type8816.data2;
+            fields[2] = data->type8816.data3;
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+/* Source text is padded for the console, trim trailing spaces */
+static int TrimmedLength(const char* text)
+{
+    int length = (int)strlen(text);
+
+    while (length > 0 && text[length - 1] == ' ')
+        length--;
+
+    return length;
+}
+
+static void WriteJsonString(const char* text, int length)
+{
+    fputc('"', out);
+    for (int i = 0; i < length; i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static void WriteCsvString(const char* text, int length)
+{
+    fputc('"', out);
+    for (int i = 0; i < length; i++)
+    {
+        if (text[i] == '"')
+            fputc('"', out);
+        fputc(text[i], out);
+    }
+    fputc('"', out);
+}
+
+bool StructuredOutput_Open(const char* filename, StructuredFormat format)
+{
+    if (strcmp(filename, "-") == 0)
+    {
+        out = stdout;
+    }
+    else
+    {
+        out = fopen(filename, "w");
+        if (out == NULL)
+        {
+            fprintf(stderr, "Unable to open file to write structured data: %s\n", filename);
+            return false;
+        }
+        setvbuf(out, NULL, _IOFBF, FILE_BUFFER_SIZE);
+    }
+
+    outFormat = format;
+
+    if (outFormat == STRUCTURED_CSV)
+        fprintf(out, "time_us,sequence,lost,source,source_name,id,type,data1,data2,data3,data4,text\n");
+
+    return true;
+}
+
+void StructuredOutput_Observe(const ConsoleMessageRecord* record)
+{
+    const ConsoleMessage* message = record->message;
+    uint32_t fields[FIELD_MAX];
+    int fieldCount = MessageFields(message, fields);
+    const char* type = typeText[message->sourceType & 0x0F];
+
+    if (outFormat == STRUCTURED_JSONL)
+    {
+        fprintf(out, "{\"time_us\":%llu,\"sequence\":%u,\"lost\":%lu,\"source\":%u,\"source_name\":",
+                (unsigned long long)record->timeUs, record->sequence, record->lost, message->sourceType >> 4);
+        WriteJsonString(record->sourceText, TrimmedLength(record->sourceText));
+        fprintf(out, ",\"id\":%u,\"type\":\"%s\",\"data\":[", message->messageId, type);
+        for (int i = 0; i < fieldCount; i++)
+            fprintf(out, i ? ",%lu" : "%lu", (unsigned long)fields[i]);
+        fprintf(out, "],\"text\":");
+        WriteJsonString(record->text, TrimmedLength(record->text));
+        fprintf(out, "}\n");
+    }
+    else
+    {
+        fprintf(out, "%llu,%u,%lu,%u,", (unsigned long long)record->timeUs, record->sequence,
+                record->lost, message->sourceType >> 4);
+        WriteCsvString(record->sourceText, TrimmedLength(record->sourceText));
+        fprintf(out, ",%u,%s", message->messageId, type);
+        for (int i = 0; i < FIELD_MAX; i++)
+        {
+            if (i < fieldCount)
+                fprintf(out, ",%lu", (unsigned long)fields[i]);
+            else
+                fputc(',', out);
+        }
+        fputc(',', out);
+        WriteCsvString(record->text, TrimmedLength(record->text));
+        fputc('\n', out);
+    }
+}
+
+void StructuredOutput_Close(void)
+{
+    if (out != NULL && out != stdout)
+        fclose(out);
+    else if (out == stdout)
+        fflush(out);
+    out = NULL;
+}
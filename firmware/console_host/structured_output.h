@@ -0,0 +1,21 @@
+#ifndef STRUCTURED_OUTPUT_H_
+#define STRUCTURED_OUTPUT_H_
+
+#include <stdbool.h>
+
+#include "console_expansion.h"
+
+typedef enum _StructuredFormat
+{
+    STRUCTURED_JSONL,
+    STRUCTURED_CSV,
+} StructuredFormat;
+
+/* Writes one machine readable record per decoded message. A filename of
+ * "-" writes to stdout. Register StructuredOutput_Observe as a message
+ * observer. */
+bool StructuredOutput_Open(const char* filename, StructuredFormat format);
+void StructuredOutput_Observe(const ConsoleMessageRecord* record);
+void StructuredOutput_Close(void);
+
+#endif /* STRUCTURED_OUTPUT_H_ */